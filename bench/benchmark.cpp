@@ -0,0 +1,65 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace standardese_bench;
+
+benchmark_runner::benchmark_runner(int argc, char* argv[]) : min_time_(0.5)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 19, "--benchmark_filter=") == 0)
+            filter_ = arg.substr(19);
+        else if (arg.compare(0, 21, "--benchmark_min_time=") == 0)
+            min_time_ = std::stod(arg.substr(21));
+        else
+            throw std::invalid_argument("unknown argument '" + arg + "'");
+    }
+}
+
+void benchmark_runner::add(std::string name, std::function<void(benchmark_state&)> function,
+                           std::vector<std::int64_t> arguments)
+{
+    benchmarks_.push_back({std::move(name), std::move(function), std::move(arguments)});
+}
+
+void benchmark_runner::run() const
+{
+    std::printf("%-48s %14s %12s %14s\n", "benchmark", "time", "iterations", "throughput");
+    for (auto& bench : benchmarks_)
+        for (auto argument : bench.arguments)
+        {
+            auto name = bench.name + '/' + std::to_string(argument);
+            if (name.find(filter_) == std::string::npos)
+                continue;
+
+            std::uint64_t iterations = 1u;
+            while (true)
+            {
+                benchmark_state state(argument, iterations);
+                bench.function(state);
+
+                auto elapsed = state.elapsed();
+                if (elapsed >= min_time_ || iterations >= 1000000000u)
+                {
+                    std::printf("%-48s %11.3f us %12llu %9.1f MB/s\n", name.c_str(),
+                                elapsed / double(iterations) * 1e6,
+                                static_cast<unsigned long long>(iterations),
+                                double(state.bytes_processed()) / elapsed / 1e6);
+                    break;
+                }
+
+                // aim a bit above the minimal time, but don't grow too fast on tiny measurements
+                auto factor = elapsed > 0. ? min_time_ * 1.4 / elapsed : 10.;
+                iterations  = std::max(iterations + 1u,
+                                      std::uint64_t(double(iterations) * std::min(factor, 10.)));
+            }
+        }
+}
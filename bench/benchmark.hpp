@@ -0,0 +1,118 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCH_BENCHMARK_HPP_INCLUDED
+#define STANDARDESE_BENCH_BENCHMARK_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace standardese_bench
+{
+/// The state of a running microbenchmark, modelled after Google Benchmark.
+///
+/// A benchmark prepares its input, then runs the measured code in a `while (state.keep_running())`
+/// loop.
+class benchmark_state
+{
+public:
+    /// \effects Creates a state that runs the loop `iterations` times.
+    benchmark_state(std::int64_t argument, std::uint64_t iterations)
+    : argument_(argument), iterations_(iterations), done_(0u), bytes_(0u), started_(false)
+    {}
+
+    /// \returns Whether or not the measured code should run once more.
+    /// \notes The time is measured from the first call to the last one.
+    bool keep_running()
+    {
+        if (!started_)
+        {
+            started_ = true;
+            start_   = clock::now();
+        }
+
+        if (done_ == iterations_)
+        {
+            end_ = clock::now();
+            return false;
+        }
+        ++done_;
+        return true;
+    }
+
+    /// \returns The argument the benchmark is run with, e.g. the size of the input.
+    std::int64_t argument() const noexcept
+    {
+        return argument_;
+    }
+
+    /// \returns The number of iterations of the loop.
+    std::uint64_t iterations() const noexcept
+    {
+        return iterations_;
+    }
+
+    /// \effects Sets the number of bytes processed by all iterations,
+    /// so the throughput can be reported.
+    void set_bytes_processed(std::uint64_t bytes) noexcept
+    {
+        bytes_ = bytes;
+    }
+
+    /// \returns The number of bytes processed by all iterations.
+    std::uint64_t bytes_processed() const noexcept
+    {
+        return bytes_;
+    }
+
+    /// \returns The time spent in the loop, in seconds.
+    double elapsed() const noexcept
+    {
+        return std::chrono::duration<double>(end_ - start_).count();
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point start_, end_;
+    std::int64_t      argument_;
+    std::uint64_t     iterations_, done_, bytes_;
+    bool              started_;
+};
+
+/// Runs microbenchmarks and reports their time per iteration and throughput.
+class benchmark_runner
+{
+public:
+    /// \effects Creates a runner configured by the command line.
+    /// It understands `--benchmark_filter=<substring>` and `--benchmark_min_time=<seconds>`.
+    /// \throws `std::invalid_argument` if there are unknown arguments.
+    benchmark_runner(int argc, char* argv[]);
+
+    /// \effects Registers a benchmark that is run once for each argument.
+    void add(std::string name, std::function<void(benchmark_state&)> function,
+             std::vector<std::int64_t> arguments);
+
+    /// \effects Runs all benchmarks that match the filter,
+    /// increasing the number of iterations until they run at least the minimal time.
+    void run() const;
+
+private:
+    struct benchmark
+    {
+        std::string                           name;
+        std::function<void(benchmark_state&)> function;
+        std::vector<std::int64_t>             arguments;
+    };
+
+    std::vector<benchmark> benchmarks_;
+    std::string            filter_;
+    double                 min_time_;
+};
+} // namespace standardese_bench
+
+#endif // STANDARDESE_BENCH_BENCHMARK_HPP_INCLUDED
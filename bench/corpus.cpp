@@ -0,0 +1,201 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "corpus.hpp"
+
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace standardese_bench;
+
+namespace
+{
+// std::mt19937 produces the same sequence everywhere, unlike the standard distributions
+class generator
+{
+public:
+    explicit generator(std::uint32_t seed) : rng_(seed) {}
+
+    unsigned next(unsigned max)
+    {
+        return max == 0u ? 0u : unsigned(rng_() % max);
+    }
+
+    std::string sentence(unsigned words, bool capitalize = true)
+    {
+        static const char* const vocabulary[]
+            = {"lorem",   "ipsum",  "dolor",  "sit",     "amet",    "consectetur", "adipiscing",
+               "elit",    "sed",    "do",     "eiusmod", "tempor",  "incididunt",  "ut",
+               "labore",  "et",     "dolore", "magna",   "aliqua",  "enim",        "ad",
+               "minim",   "veniam", "quis",   "nostrud", "ullamco", "laboris",     "nisi",
+               "aliquip", "ex",     "ea",     "commodo"};
+        constexpr auto vocabulary_size = sizeof(vocabulary) / sizeof(vocabulary[0]);
+
+        std::string result;
+        for (auto i = 0u; i != words; ++i)
+        {
+            if (i != 0u)
+                result += ' ';
+            result += vocabulary[next(vocabulary_size)];
+        }
+        if (capitalize && !result.empty())
+            result[0] = char(result[0] - 'a' + 'A');
+        return result;
+    }
+
+private:
+    std::mt19937 rng_;
+};
+
+std::string get_namespace(unsigned file, unsigned level)
+{
+    // namespaces are shared between files, like modules of a library
+    return "ns" + std::to_string(level) + "_" + std::to_string(file % (level + 2u));
+}
+
+std::string get_scope(const corpus_config& config, unsigned file)
+{
+    std::string result;
+    for (auto level = 0u; level != config.namespace_depth; ++level)
+        result += get_namespace(file, level) + "::";
+    return result;
+}
+
+std::string get_class_name(unsigned file, unsigned c)
+{
+    return "class_" + std::to_string(file) + "_" + std::to_string(c);
+}
+
+void write_details(std::ostream& out, const std::string& indent, const corpus_config& config,
+                   generator& gen)
+{
+    if (config.comment_lines == 0u)
+        return;
+
+    out << indent << "///\n";
+    auto capitalize = true;
+    for (auto i = 0u; i != config.comment_lines; ++i)
+    {
+        // a sentence spans up to three lines
+        auto end_sentence = i % 3u == 2u || i + 1u == config.comment_lines;
+        out << indent << "/// " << gen.sentence(10u, capitalize) << (end_sentence ? ".\n" : "\n");
+        capitalize = end_sentence;
+    }
+}
+
+void write_function(std::ostream& out, const corpus_config& config, generator& gen,
+                    const std::string& class_name, unsigned f)
+{
+    static const char* const types[] = {"int", "double", "long", "char", "bool", "const char*"};
+
+    auto name = "function_" + std::to_string(f);
+    for (auto overload = 0u; overload != config.overloads; ++overload)
+    {
+        // group names are global, so they need the class name
+        if (config.groups && overload != 0u)
+            out << "        /// \\group " << class_name << '_' << name << "\n";
+        else
+        {
+            if (config.groups)
+                out << "        /// \\group " << class_name << '_' << name << " Function " << f
+                    << "\n";
+            out << "        /// " << gen.sentence(8u) << ".\n";
+            write_details(out, "        ", config, gen);
+            if (config.param_docs)
+                for (auto param = 0u; param <= overload; ++param)
+                    out << "        /// \\param p" << param << " " << gen.sentence(6u) << ".\n";
+            out << "        /// \\returns " << gen.sentence(6u) << ".\n";
+        }
+
+        out << "        int " << name << '(';
+        for (auto param = 0u; param <= overload; ++param)
+        {
+            if (param != 0u)
+                out << ", ";
+            out << types[(f + param) % (sizeof(types) / sizeof(types[0]))] << " p" << param;
+        }
+        out << ") const;\n\n";
+    }
+}
+
+void write_class(std::ostream& out, const corpus_config& config, generator& gen, unsigned file,
+                 unsigned c)
+{
+    out << "    /// " << gen.sentence(8u) << ".\n";
+    write_details(out, "    ", config, gen);
+    for (auto i = 0u; i != config.cross_references; ++i)
+    {
+        if (i % 2u == 0u || config.classes < 2u)
+        {
+            // absolute link to any class of the API
+            auto other_file  = gen.next(config.files);
+            auto other_class = gen.next(config.classes);
+            out << "    /// See [" << get_scope(config, other_file)
+                << get_class_name(other_file, other_class) << "]().\n";
+        }
+        else
+            // relative link, looked up in the scope of the class and its parents
+            out << "    /// See [?" << get_class_name(file, gen.next(config.classes)) << "]().\n";
+    }
+
+    auto name = get_class_name(file, c);
+    out << "    class " << name << "\n    {\n    public:\n";
+    for (auto f = 0u; f != config.functions; ++f)
+        write_function(out, config, gen, name, f);
+    out << "    private:\n        int member_;\n    };\n\n";
+}
+
+void write_template(std::ostream& out, const corpus_config& config, generator& gen, unsigned file,
+                    unsigned t)
+{
+    out << "    /// " << gen.sentence(8u) << ".\n";
+    write_details(out, "    ", config, gen);
+    if (config.param_docs)
+        out << "    /// \\tparam T " << gen.sentence(6u) << ".\n"
+            << "    /// \\tparam N " << gen.sentence(6u) << ".\n";
+    out << "    template <typename T, int N = " << t << ">\n"
+        << "    class template_" << file << "_" << t << "\n    {\n    public:\n"
+        << "        /// " << gen.sentence(8u) << ".\n";
+    if (config.param_docs)
+        out << "        /// \\param value " << gen.sentence(6u) << ".\n";
+    out << "        /// \\returns " << gen.sentence(6u) << ".\n"
+        << "        T get(const T& value) const;\n\n"
+        << "        /// " << gen.sentence(8u) << ".\n"
+        << "        template <typename U>\n"
+        << "        void set(U&& value);\n    };\n\n";
+}
+} // namespace
+
+std::vector<fs::path> standardese_bench::generate_corpus(const corpus_config& config,
+                                                         const fs::path&      directory)
+{
+    fs::create_directories(directory);
+
+    generator             gen(config.seed);
+    std::vector<fs::path> result;
+    for (auto file = 0u; file != config.files; ++file)
+    {
+        auto          path = directory / ("file_" + std::to_string(file) + ".hpp");
+        std::ofstream out(path.string());
+
+        out << "// generated by standardese_bench\n\n";
+        out << "#ifndef BENCH_FILE_" << file << "_HPP_INCLUDED\n";
+        out << "#define BENCH_FILE_" << file << "_HPP_INCLUDED\n\n";
+        out << "/// \\file\n/// " << gen.sentence(8u) << ".\n\n";
+
+        for (auto level = 0u; level != config.namespace_depth; ++level)
+            out << "namespace " << get_namespace(file, level) << "\n{\n";
+        for (auto c = 0u; c != config.classes; ++c)
+            write_class(out, config, gen, file, c);
+        for (auto t = 0u; t != config.templates; ++t)
+            write_template(out, config, gen, file, t);
+        for (auto level = 0u; level != config.namespace_depth; ++level)
+            out << "}\n";
+
+        out << "\n#endif\n";
+        result.push_back(std::move(path));
+    }
+    return result;
+}
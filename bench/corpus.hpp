@@ -0,0 +1,39 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCH_CORPUS_HPP_INCLUDED
+#define STANDARDESE_BENCH_CORPUS_HPP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "../tool/filesystem.hpp"
+
+namespace standardese_bench
+{
+namespace fs = standardese_tool::fs;
+
+/// The shape of a synthetic API.
+struct corpus_config
+{
+    unsigned      files            = 50u;  //< Number of header files.
+    unsigned      namespace_depth  = 3u;   //< Nesting depth of the namespaces in each file.
+    unsigned      classes          = 10u;  //< Classes per file.
+    unsigned      functions        = 5u;   //< Member functions per class.
+    unsigned      overloads        = 3u;   //< Overloads of each member function.
+    unsigned      templates        = 2u;   //< Class templates per file.
+    unsigned      comment_lines    = 4u;   //< Lines of details in each comment.
+    unsigned      cross_references = 2u;   //< Links to other classes in each class comment.
+    bool          param_docs       = true; //< Whether functions document their parameters inline.
+    bool          groups           = true; //< Whether the overloads of a function are grouped.
+    std::uint32_t seed             = 42u;  //< Seed for the words and link targets.
+};
+
+/// \effects Writes the headers of a synthetic API into `directory`.
+/// The content only depends on the configuration, so every run generates the same headers.
+/// \returns The paths of the headers.
+std::vector<fs::path> generate_corpus(const corpus_config& config, const fs::path& directory);
+} // namespace standardese_bench
+
+#endif // STANDARDESE_BENCH_CORPUS_HPP_INCLUDED
@@ -0,0 +1,300 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#if !defined(__linux__) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/resource.h>
+#endif
+
+#include "../tool/generator.hpp"
+#include "../tool/profiler.hpp"
+#include "../tool/thread_pool.hpp"
+#include "corpus.hpp"
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+namespace
+{
+#if defined(__linux__)
+// the peak can be reset on Linux, so each stage is measured on its own
+void reset_peak_rss()
+{
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+std::uint64_t get_peak_rss()
+{
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);)
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stoull(line.substr(6)) * 1024u;
+    return 0u;
+}
+#elif defined(__unix__) || defined(__APPLE__)
+// the peak can't be reset, so it is the peak of all stages so far
+void reset_peak_rss() {}
+
+std::uint64_t get_peak_rss()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return std::uint64_t(usage.ru_maxrss);
+#else
+    return std::uint64_t(usage.ru_maxrss) * 1024u;
+#endif
+}
+#else
+void reset_peak_rss() {}
+
+std::uint64_t get_peak_rss()
+{
+    return 0u;
+}
+#endif
+
+struct stage_result
+{
+    const char*   name;
+    const char*   unit;
+    double        seconds;
+    double        amount; // of unit, processed during the stage
+    std::uint64_t peak_rss;
+};
+
+template <typename Func>
+stage_result measure(const char* name, const char* unit, Func f)
+{
+    reset_peak_rss();
+    auto start  = std::chrono::steady_clock::now();
+    auto amount = f();
+    auto end    = std::chrono::steady_clock::now();
+    return {name, unit, std::chrono::duration<double>(end - start).count(), double(amount),
+            get_peak_rss()};
+}
+
+std::vector<stage_result> run(const std::vector<standardese_tool::input_file>& inputs,
+                              std::uint64_t                                       input_bytes,
+                              const std::vector<standardese_tool::output_format>& formats,
+                              standardese_tool::thread_pool&                      pool,
+                              standardese_tool::profiler&                         profiler)
+{
+    auto profile = type_safe::opt_ref(&profiler);
+
+    cppast::libclang_compile_config config;
+    config.set_flags(cppast::cpp_standard::cpp_17);
+    type_safe::optional<cppast::libclang_compilation_database> database;
+
+    standardese::entity_blacklist    blacklist;
+    standardese::generation_config   gen_config;
+    standardese::synopsis_config     syn_config;
+    standardese::linker              linker;
+    cppast::cpp_entity_index         index;
+    standardese::file_comment_parser comment_parser(cppast::default_logger());
+
+    type_safe::optional<std::vector<standardese_tool::parsed_file>> parsed;
+    standardese::comment_registry                                   comments;
+    std::vector<std::unique_ptr<standardese::doc_cpp_file>>         files;
+    standardese_tool::documents                                     docs;
+
+    std::vector<stage_result> result;
+    result.push_back(measure("parsing", "MB", [&] {
+        parsed = standardese_tool::parse(config, database, false, inputs, index, comment_parser,
+                                         pool, profile);
+        if (!parsed)
+            throw std::runtime_error("unable to parse the generated headers");
+        return input_bytes / 1e6;
+    }));
+
+    result.push_back(measure("building entities", "entities", [&] {
+        comments = comment_parser.finish();
+        files    = standardese_tool::build_files(comments, index, std::move(parsed.value()),
+                                              blacklist, false, pool, profile);
+        return profiler.counter("entities");
+    }));
+
+    result.push_back(measure("generating documentation", "entities", [&] {
+        docs = standardese_tool::generate(gen_config, syn_config, comments, index, linker, files,
+                                          pool, profile);
+        return profiler.counter("entities");
+    }));
+
+    result.push_back(measure("writing files", "MB", [&] {
+        standardese_tool::write_files(docs, formats, pool, nullptr, profile);
+        return profiler.counter("bytes written") / 1e6;
+    }));
+
+    // the documents are allocated from arenas, so this should be cheap
+    result.push_back(measure("freeing documents", "documents", [&] {
+        auto count = docs.entities.size();
+        // the documents must be destroyed before the arenas they are allocated from
+        docs.entities.clear();
+        docs.arenas.clear();
+        files.clear();
+        return count;
+    }));
+
+    return result;
+}
+
+void print_results(const std::vector<stage_result>& results)
+{
+    std::printf("%-28s %12s %24s %12s\n", "stage", "time", "throughput", "peak RSS");
+    for (auto& stage : results)
+    {
+        char throughput[64];
+        std::snprintf(throughput, sizeof(throughput), "%.1f %s/s",
+                      stage.seconds > 0 ? stage.amount / stage.seconds : 0., stage.unit);
+
+        char rss[32];
+        if (stage.peak_rss == 0u)
+            std::snprintf(rss, sizeof(rss), "n/a");
+        else
+            std::snprintf(rss, sizeof(rss), "%.1f MB", double(stage.peak_rss) / 1e6);
+
+        std::printf("%-28s %9.1f ms %24s %12s\n", stage.name, stage.seconds * 1e3, throughput,
+                    rss);
+    }
+}
+
+standardese_tool::output_format get_format(const std::string& format, const fs::path& prefix)
+{
+    auto make = [&](standardese::markup::generator generator, const char* extension) {
+        fs::create_directories(prefix / extension);
+        return standardese_tool::output_format{generator, extension,
+                                               (prefix / extension).string() + '/'};
+    };
+
+    if (format == "html")
+        return make(standardese::markup::html_generator("", "html"), "html");
+    else if (format == "xml")
+        return make(standardese::markup::xml_generator(), "xml");
+    else if (format == "commonmark")
+        return make(standardese::markup::markdown_generator(false, "", "md"), "md");
+    else if (format == "commonmark_html")
+        return make(standardese::markup::markdown_generator(true, "", "md"), "md");
+    else if (format == "text")
+        return make(standardese::markup::text_generator(), "txt");
+    else
+        throw std::invalid_argument("unknown format '" + format + "'");
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    standardese_bench::corpus_config corpus;
+
+    // clang-format off
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "prints this help message and exits")
+        ("directory", po::value<fs::path>()->default_value(fs::temp_directory_path() / "standardese_bench"),
+         "the directory where the headers and the documentation are written to")
+        ("runs", po::value<unsigned>()->default_value(3u),
+         "how often the headers are documented, the fastest time of each stage is reported")
+        ("jobs,j", po::value<unsigned>()->default_value(standardese_tool::default_no_threads()),
+         "sets the number of threads to use")
+        ("format", po::value<std::vector<std::string>>()->default_value({"html"}, "html"),
+         "the output formats: html, xml, commonmark, commonmark_html or text")
+        ("profile", po::value<fs::path>(),
+         "writes a trace of the last run to the given file, see the option of the tool")
+        ("files", po::value<unsigned>(&corpus.files)->default_value(corpus.files),
+         "number of header files")
+        ("namespace_depth", po::value<unsigned>(&corpus.namespace_depth)->default_value(corpus.namespace_depth),
+         "nesting depth of the namespaces in each file")
+        ("classes", po::value<unsigned>(&corpus.classes)->default_value(corpus.classes),
+         "classes per file")
+        ("functions", po::value<unsigned>(&corpus.functions)->default_value(corpus.functions),
+         "member functions per class")
+        ("overloads", po::value<unsigned>(&corpus.overloads)->default_value(corpus.overloads),
+         "overloads of each member function")
+        ("templates", po::value<unsigned>(&corpus.templates)->default_value(corpus.templates),
+         "class templates per file")
+        ("comment_lines", po::value<unsigned>(&corpus.comment_lines)->default_value(corpus.comment_lines),
+         "lines of details in each comment")
+        ("cross_references", po::value<unsigned>(&corpus.cross_references)->default_value(corpus.cross_references),
+         "links to other classes in each class comment, alternating between absolute and relative links")
+        ("param_docs", po::value<bool>(&corpus.param_docs)->default_value(corpus.param_docs),
+         "whether functions document their parameters with \\param")
+        ("groups", po::value<bool>(&corpus.groups)->default_value(corpus.groups),
+         "whether the overloads of a function are put into a \\group")
+        ("seed", po::value<std::uint32_t>(&corpus.seed)->default_value(corpus.seed),
+         "seed for the words of the comments and the link targets");
+    // clang-format on
+
+    try
+    {
+        po::variables_map map;
+        po::store(po::parse_command_line(argc, argv, options), map);
+        po::notify(map);
+
+        if (map.count("help"))
+        {
+            std::cout << "Usage: " << argv[0] << " [options]\n\n"
+                      << "Generates a synthetic API and measures how long documenting it takes.\n\n"
+                      << options << '\n';
+            return 0;
+        }
+
+        auto directory = map["directory"].as<fs::path>();
+        auto runs      = std::max(map["runs"].as<unsigned>(), 1u);
+
+        std::vector<standardese_tool::output_format> formats;
+        for (auto& format : map["format"].as<std::vector<std::string>>())
+            formats.push_back(get_format(format, directory / "output"));
+
+        std::vector<standardese_tool::input_file> inputs;
+        std::uint64_t                             input_bytes = 0u;
+        for (auto& path : standardese_bench::generate_corpus(corpus, directory / "input"))
+        {
+            input_bytes += fs::file_size(path);
+            inputs.push_back({path, path.filename()});
+        }
+
+        standardese_tool::thread_pool pool(map["jobs"].as<unsigned>());
+
+        std::vector<stage_result> best;
+        for (auto i = 0u; i != runs; ++i)
+        {
+            std::clog << "run " << i + 1 << " of " << runs << "...\n";
+
+            standardese_tool::profiler profiler;
+            auto                       results = run(inputs, input_bytes, formats, pool, profiler);
+            if (best.empty())
+            {
+                std::cout << inputs.size() << " files with " << input_bytes << " bytes, "
+                          << profiler.counter("entities") << " entities, "
+                          << profiler.counter("comments") << " comments, "
+                          << profiler.counter("links") << " links and "
+                          << profiler.counter("bytes written") << " bytes written\n\n";
+                best = results;
+            }
+            else
+                for (auto stage = 0u; stage != results.size(); ++stage)
+                {
+                    best[stage].seconds  = std::min(best[stage].seconds, results[stage].seconds);
+                    best[stage].peak_rss = std::max(best[stage].peak_rss, results[stage].peak_rss);
+                }
+
+            if (i + 1 == runs && map.count("profile"))
+                profiler.write(map["profile"].as<fs::path>());
+        }
+
+        print_results(best);
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,210 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+
+#include <standardese/markup/code_block.hpp>
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/generator.hpp>
+#include <standardese/markup/heading.hpp>
+#include <standardese/markup/index.hpp>
+#include <standardese/markup/list.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+
+#include "benchmark.hpp"
+
+using namespace standardese::markup;
+using standardese_bench::benchmark_state;
+
+namespace
+{
+// counts the bytes written to it and discards them,
+// so the benchmarks measure the generators and not the growth of a string
+class counting_buffer : public std::streambuf
+{
+public:
+    counting_buffer() : count_(0u)
+    {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    std::uint64_t count() const noexcept
+    {
+        return count_ + std::uint64_t(pptr() - pbase());
+    }
+
+private:
+    int_type overflow(int_type c) override
+    {
+        count_ += std::uint64_t(pptr() - pbase());
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    char          buffer_[4096];
+    std::uint64_t count_;
+};
+
+// a synopsis with the given number of highlighted declarations
+std::unique_ptr<document_entity> build_synopsis(std::int64_t lines)
+{
+    code_block::builder code(block_id("synopsis"), "cpp");
+    for (auto i = 0; i != lines; ++i)
+    {
+        code.add_child(code_block::keyword::build("template"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::punctuation::build("<"));
+        code.add_child(code_block::keyword::build("typename"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::identifier::build("T"));
+        code.add_child(code_block::punctuation::build(">"));
+        code.add_child(text::build("\n"));
+        code.add_child(code_block::keyword::build("void"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::identifier::build("function_" + std::to_string(i)));
+        code.add_child(code_block::punctuation::build("("));
+        code.add_child(code_block::keyword::build("const"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::identifier::build("T"));
+        code.add_child(code_block::punctuation::build("&"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::identifier::build("value"));
+        code.add_child(code_block::punctuation::build(","));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::keyword::build("int"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::identifier::build("n"));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::punctuation::build("="));
+        code.add_child(text::build(" "));
+        code.add_child(code_block::int_literal::build("42"));
+        code.add_child(code_block::punctuation::build(");"));
+        code.add_child(text::build("\n\n"));
+    }
+
+    main_document::builder document("Synopsis", "synopsis");
+    document.add_child(code.finish());
+    return document.finish();
+}
+
+std::unique_ptr<block_entity> build_list(std::int64_t depth)
+{
+    unordered_list::builder list{block_id()};
+    for (auto i = 0; i != 3; ++i)
+        list.add_item(list_item::build(paragraph::builder()
+                                           .add_child(text::build("Item " + std::to_string(i)
+                                                                  + " with "))
+                                           .add_child(emphasis::build("emphasis"))
+                                           .add_child(text::build(" and "))
+                                           .add_child(code::build("code"))
+                                           .finish()));
+    if (depth > 1)
+        list.add_item(list_item::builder()
+                          .add_child(paragraph::builder()
+                                         .add_child(text::build("Nested list"))
+                                         .finish())
+                          .add_child(build_list(depth - 1))
+                          .finish());
+    return list.finish();
+}
+
+// lists nested to the given depth
+std::unique_ptr<document_entity> build_nested_lists(std::int64_t depth)
+{
+    main_document::builder document("Nested lists", "lists");
+    document.add_child(build_list(depth));
+    return document.finish();
+}
+
+// an entity index with the given number of entities
+std::unique_ptr<document_entity> build_entity_index(std::int64_t entities)
+{
+    entity_index::builder index(heading::build(block_id(), "Project index"));
+    for (auto i = 0; i != entities; ++i)
+    {
+        auto name = "entity_" + std::to_string(i);
+        index.add_child(
+            entity_index_item::build(block_id(name), term::build(code::build("ns::" + name)),
+                                     description::build(
+                                         text::build("The brief documentation of " + name + "."))));
+    }
+
+    main_document::builder document("Project index", "index");
+    document.add_child(index.finish());
+    return document.finish();
+}
+
+void run_generator(benchmark_state& state, const generator& gen, const document_entity& document)
+{
+    counting_buffer buffer;
+    std::ostream    out(&buffer);
+    while (state.keep_running())
+        gen(out, document);
+    state.set_bytes_processed(buffer.count());
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        standardese_bench::benchmark_runner runner(argc, argv);
+
+        struct
+        {
+            const char* name;
+            generator   gen;
+        } generators[] = {{"html", html_generator("", "html")},
+                          {"markdown", markdown_generator(false, "", "md")},
+                          {"markdown_html", markdown_generator(true, "", "md")},
+                          {"xml", xml_generator()},
+                          {"text", text_generator()}};
+
+        using document_builder = std::unique_ptr<document_entity> (*)(std::int64_t);
+        struct
+        {
+            const char*               name;
+            document_builder          build;
+            std::vector<std::int64_t> sizes;
+        } documents[] = {{"synopsis", &build_synopsis, {64, 512, 4096}},
+                         {"nested_lists", &build_nested_lists, {4, 16, 64}},
+                         {"entity_index", &build_entity_index, {64, 512, 4096}}};
+
+        for (auto& document : documents)
+        {
+            // the documents are built once and shared by the benchmarks of all generators
+            auto prebuilt
+                = std::make_shared<std::map<std::int64_t, std::unique_ptr<document_entity>>>();
+            for (auto size : document.sizes)
+                (*prebuilt)[size] = document.build(size);
+
+            for (auto& format : generators)
+            {
+                auto gen = format.gen;
+                runner.add(std::string(format.name) + '/' + document.name,
+                           [prebuilt, gen](benchmark_state& state) {
+                               run_generator(state, gen, *prebuilt->at(state.argument()));
+                           },
+                           document.sizes);
+            }
+        }
+
+        runner.run();
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -5,8 +5,10 @@
 #ifndef STANDARDESE_COMMENT_HPP_INCLUDED
 #define STANDARDESE_COMMENT_HPP_INCLUDED
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "index.hpp"
 #include <standardese/comment/config.hpp>
@@ -26,6 +28,8 @@ namespace standardese
 class comment_registry
 {
 public:
+    comment_registry() = default;
+
     /// \effects Registers everything from the other comment registry.
     void merge(comment_registry&& other);
 
@@ -65,22 +69,69 @@ public:
     }
 
 private:
+    // unique name of the entity ignoring its own `\unique_name` command
+    std::string get_default_unique_name(const cppast::cpp_entity& e) const;
+
+    // unique name of the scope the entity lives in
+    std::string get_parent_unique_name(const cppast::cpp_entity& e) const;
+
+    // the default unique names are needed over and over again for child entities,
+    // so they're cached; the cache is invalidated when a comment changes a unique name
+    struct unique_name_cache
+    {
+        std::mutex                                                  mutex;
+        std::unordered_map<const cppast::cpp_entity*, std::string> names;
+
+        unique_name_cache() = default;
+
+        // the names aren't moved along with the comments, they're just computed again,
+        // so both registries are left with a valid, empty cache
+        unique_name_cache(unique_name_cache&& other) noexcept
+        {
+            other.names.clear();
+        }
+
+        unique_name_cache& operator=(unique_name_cache&& other) noexcept
+        {
+            names.clear();
+            other.names.clear();
+            return *this;
+        }
+    };
+
     std::unordered_map<const cppast::cpp_entity*, comment::doc_comment> map_;
     std::unordered_map<std::string, std::vector<type_safe::object_ref<const cppast::cpp_entity>>>
                                                           groups_;
     std::unordered_map<std::string, comment::doc_comment> modules_;
+    mutable unique_name_cache                             unique_names_;
+
+    friend std::string lookup_unique_name(const comment_registry&   registry,
+                                          const cppast::cpp_entity& e);
+    friend class file_comment_parser;
 };
 
 /// \returns The unique name of the given entity.
+/// \notes The unique names of the parents are cached inside the registry,
+/// so it is cheap to call this function for every entity.
+/// This function is thread safe as long as no comments are registered concurrently.
 std::string lookup_unique_name(const comment_registry& registry, const cppast::cpp_entity& e);
 
+class entity_blacklist;
+
 /// Parses the comments in several files and connects them in a shared registry.
 class file_comment_parser
 {
 public:
+    /// \effects Creates a parser using the given configuration.
+    /// If a blacklist is given, the comments of blacklisted entities and their children are only
+    /// scanned for commands, as their documentation will never be used.
+    /// The children that are class members are still parsed completely,
+    /// as they are documented in a derived class if their class is an excluded public base.
     explicit file_comment_parser(type_safe::object_ref<const cppast::diagnostic_logger> logger,
-                                 comment::config config = comment::config())
-    : config_(std::move(config)), logger_(logger)
+                                 comment::config config = comment::config(),
+                                 type_safe::optional_ref<const entity_blacklist> blacklist
+                                 = nullptr)
+    : config_(std::move(config)), logger_(logger), blacklist_(blacklist)
     {}
 
     /// Parse all comments in `file`.
@@ -94,35 +145,76 @@ public:
     comment_registry finish();
 
 private:
+    /// The comments of a single file.
+    /// They are collected by the thread parsing the file without any locking.
+    struct file_comments
+    {
+        std::string                                                      file_name;
+        comment_registry                                                 registry;
+        std::unordered_multimap<std::string, const cppast::cpp_entity*> uncommented;
+        std::vector<comment::parse_result>                               free_comments;
+    };
+
+    /// \effects Merges the comments of one file into `result`.
+    void merge(file_comments& result, file_comments&& file) const;
+
     /// Connect free comments with an `\entity` command to their respective entities.
-    /// \notes This function is not thread-safe.
-    void resolve_free_comments();
+    void resolve_free_comments(file_comments& result) const;
 
     /// Group uncommented entities with preceding commented entities.
-    /// \notes This function is not thread-safe.
-    void group_uncommented();
+    void group_uncommented(file_comments& result) const;
 
-    bool register_commented(type_safe::object_ref<const cppast::cpp_entity> entity,
+    bool register_commented(file_comments&                                  result,
+                            type_safe::object_ref<const cppast::cpp_entity> entity,
                             comment::doc_comment comment, bool allow_cmd = true) const;
 
-    void register_uncommented(type_safe::object_ref<const cppast::cpp_entity> entity) const;
+    void register_uncommented(file_comments&                                  result,
+                              type_safe::object_ref<const cppast::cpp_entity> entity) const;
 
-    type_safe::optional_ref<const comment::doc_comment> get_comment(
-        const cppast::cpp_entity& e) const
+    /// \returns A CommonMark parser that is not in use by any other thread.
+    /// \notes Setting up a parser with all the extensions is expensive,
+    /// so they are pooled and reused for subsequent comments.
+    std::unique_ptr<comment::parser> acquire_parser() const;
+
+    /// \effects Returns a parser obtained by `acquire_parser()` to the pool.
+    void release_parser(std::unique_ptr<comment::parser> parser) const noexcept;
+
+    /// A parser from the pool that is returned to it on destruction,
+    /// even if the parsing throws.
+    class pooled_parser
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return registry_.get_comment(e);
-    }
+    public:
+        explicit pooled_parser(const file_comment_parser& pool)
+        : pool_(pool), parser_(pool.acquire_parser())
+        {}
 
-    std::string get_parent_unique_name(const cppast::cpp_entity& e) const;
+        ~pooled_parser() noexcept
+        {
+            pool_.release_parser(std::move(parser_));
+        }
+
+        pooled_parser(const pooled_parser&) = delete;
+        pooled_parser& operator=(const pooled_parser&) = delete;
+
+        const comment::parser& operator*() const noexcept
+        {
+            return *parser_;
+        }
+
+    private:
+        const file_comment_parser&       pool_;
+        std::unique_ptr<comment::parser> parser_;
+    };
+
+    mutable std::mutex                                    parsers_mutex_;
+    mutable std::vector<std::unique_ptr<comment::parser>> parsers_;
 
-    mutable std::mutex                                                      mutex_;
-    mutable std::unordered_multimap<std::string, const cppast::cpp_entity*> uncommented_;
-    mutable comment_registry                                                registry_;
-    mutable std::vector<comment::parse_result>                              free_comments_;
+    mutable std::mutex                 mutex_;
+    mutable std::vector<file_comments> files_;
 
     comment::config                                        config_;
     type_safe::object_ref<const cppast::diagnostic_logger> logger_;
+    type_safe::optional_ref<const entity_blacklist>        blacklist_;
 };
 } // namespace standardese
 
@@ -6,6 +6,8 @@
 #ifndef STANDARDESE_COMMENT_COMMANDS_HPP_INCLUDED
 #define STANDARDESE_COMMENT_COMMANDS_HPP_INCLUDED
 
+#include <variant>
+
 namespace standardese
 {
 namespace comment
@@ -69,6 +71,11 @@ namespace comment
         count,
     };
 
+    /// Any of the commands, sections, or inlines.
+    ///
+    /// The ordering of the variant is the order in which the patterns are tried,
+    /// i.e. first all [*command_type](), then [*section_type]() and then [*inline_type]().
+    using any_command = std::variant<command_type, section_type, inline_type>;
 } // namespace comment
 } // namespace standardese
 
@@ -7,8 +7,11 @@
 #define STANDARDESE_COMMENT_CONFIG_HPP_INCLUDED
 
 #include <array>
-#include <string>
 #include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <standardese/comment/commands.hpp>
 
@@ -48,6 +51,14 @@ namespace standardese::comment
         /// \returns The pattern that introduces a `cmd` inline.
         const std::regex& get_command_pattern(inline_type cmd) const;
 
+        /// \effects Replaces `result` with the commands whose pattern might match
+        /// at the beginning of `[begin, end)`, in the order they need to be tried.
+        /// \notes Commands using the default pattern are looked up by their name,
+        /// so at most one of them is a candidate.
+        /// Commands with a custom pattern are always candidates.
+        void get_command_candidates(const char* begin, const char* end,
+                                    std::vector<any_command>& result) const;
+
         /// \returns The name of a [*section_type]() in the resulting documentation.
         const char* inline_section_name(section_type section) const;
 
@@ -93,6 +104,12 @@ namespace standardese::comment
         std::vector<std::regex> section_command_patterns_;
         std::vector<std::regex> inline_command_patterns_;
 
+        // commands with a default pattern indexed by their name
+        std::unordered_map<std::string_view, any_command> default_commands_;
+        // commands with a custom pattern in the order they are tried
+        std::vector<any_command> custom_commands_;
+        char                     command_character_;
+
         bool free_file_comments_;
         bool group_uncommented_;
     };
@@ -53,7 +53,8 @@ namespace comment
     public:
         /// \effects Creates it giving the metadata and all the sections.
         /// \requires Sections must not contain the brief section.
-        doc_comment(comment::metadata metadata, std::unique_ptr<markup::brief_section> brief,
+        /// \notes The brief section is shared, so that the indices can refer to it without copying.
+        doc_comment(comment::metadata metadata, std::shared_ptr<const markup::brief_section> brief,
                     std::vector<std::unique_ptr<markup::doc_section>> sections)
         : metadata_(std::move(metadata)), sections_(std::move(sections)), brief_(std::move(brief))
         {}
@@ -86,7 +87,7 @@ namespace comment
     private:
         comment::metadata                                 metadata_;
         std::vector<std::unique_ptr<markup::doc_section>> sections_;
-        std::unique_ptr<markup::brief_section>            brief_;
+        std::shared_ptr<const markup::brief_section>      brief_;
 
         friend doc_comment merge(comment::metadata data, doc_comment&& other);
     };
@@ -32,6 +32,8 @@ namespace comment
     ///
     /// This is just a RAII wrapper over the `cmark_parser`
     /// and the [standardese::comment::config]().
+    /// A parser can be used to parse multiple comments one after the other,
+    /// but not concurrently.
     class parser
     {
     public:
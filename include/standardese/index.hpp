@@ -5,8 +5,10 @@
 #ifndef STANDARDESE_INDEX_HPP_INCLUDED
 #define STANDARDESE_INDEX_HPP_INCLUDED
 
+#include <array>
 #include <memory>
 #include <mutex>
+#include <string_view>
 #include <vector>
 
 #include <type_safe/reference.hpp>
@@ -66,24 +68,47 @@ public:
 private:
     struct entity
     {
-        std::string name, scope;
+        std::string key; // scope followed by name, what the entities are sorted by
+        std::size_t scope_length;
         type_safe::variant<std::unique_ptr<markup::entity_index_item>,
                            markup::namespace_documentation::builder>
             doc;
 
-        entity(std::unique_ptr<markup::entity_index_item> doc, std::string name, std::string scope)
-        : name(std::move(name)), scope(std::move(scope)), doc(std::move(doc))
-        {}
-
-        entity(markup::namespace_documentation::builder doc, std::string name, std::string scope)
-        : name(std::move(name)), scope(std::move(scope)), doc(std::move(doc))
-        {}
+        entity(std::unique_ptr<markup::entity_index_item> doc, const std::string& name,
+               std::string scope)
+        : key(std::move(scope)), scope_length(key.size()), doc(std::move(doc))
+        {
+            key += name;
+        }
+
+        entity(markup::namespace_documentation::builder doc, const std::string& name,
+               std::string scope)
+        : key(std::move(scope)), scope_length(key.size()), doc(std::move(doc))
+        {
+            key += name;
+        }
+
+        std::string_view scope() const noexcept
+        {
+            return std::string_view(key).substr(0, scope_length);
+        }
     };
 
     void insert(entity e) const;
 
-    mutable std::mutex          mutex_;
-    mutable std::vector<entity> entities_; // sorted by scope, then name
+    // moves all collected entities into one vector sorted by key, merging duplicates
+    std::vector<entity> sorted_entities() const;
+
+    // entities are collected unsorted in buckets selected by the registering thread,
+    // so the threads don't contend on a single lock
+    struct bucket
+    {
+        std::mutex          mutex;
+        std::vector<entity> entities;
+    };
+    static constexpr std::size_t no_buckets = 16u;
+
+    mutable std::array<bucket, no_buckets> buckets_;
 };
 
 /// Registers all entities that needs registration.
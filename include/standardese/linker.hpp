@@ -5,11 +5,16 @@
 #ifndef STANDARDESE_LINKER_HPP_INCLUDED
 #define STANDARDESE_LINKER_HPP_INCLUDED
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <mutex>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
+#include <type_safe/optional_ref.hpp>
 #include <type_safe/variant.hpp>
 
 #include <standardese/markup/link.hpp>
@@ -27,9 +32,39 @@ namespace markup
     class document_entity;
 } // namespace markup
 
+/// The scopes a relative link name is looked up in.
+///
+/// Those are the scopes of the context entity and all of its parents.
+/// They are computed once, so looking up multiple links in the same context
+/// does not need to walk the parents again.
+class link_scopes
+{
+public:
+    /// \effects Computes the scopes of the given context entity.
+    explicit link_scopes(type_safe::optional_ref<const cppast::cpp_entity> context);
+
+private:
+    struct prefix
+    {
+        std::size_t   length;
+        std::uint64_t hash;
+    };
+
+    // the scope of the context entity, i.e. `a::b::c::`
+    std::string scope_;
+    // the scope of the context entity and of each parent is a prefix of it,
+    // starting with the context entity itself
+    std::vector<prefix> prefixes_;
+
+    friend class linker;
+};
+
 /// Stores the information about the location of the entity documentation in the output.
 ///
 /// This is used to resolve documentation links.
+/// Documentations are registered first, possibly from multiple threads.
+/// Once everything is registered, the linker can be frozen,
+/// which allows lookups without any synchronization.
 class linker
 {
 public:
@@ -39,19 +74,70 @@ public:
     /// All unresolved links with that name will resolve to the given documentation.
     /// If `force` is `true`, it will replace a previous registered documentation.
     /// \returns `false` if the link name was used twice.
+    /// \requires The linker must not be frozen.
     /// \notes This function is thread safe.
     bool register_documentation(std::string link_name, const markup::document_entity& document,
                                 const markup::block_id& documentation, bool force = false) const;
 
+    /// \effects Moves all registered documentations into a read-only lookup table.
+    /// \requires This function must not be called concurrently with any other member function.
+    /// \notes Afterwards no documentation can be registered anymore.
+    void freeze();
+
+    /// \returns Whether or not the linker is frozen.
+    bool is_frozen() const noexcept
+    {
+        return !slots_.empty();
+    }
+
     /// \returns A reference to the documentation for the given linke name, if there is any.
-    /// \notes This function is thread safe.
+    /// \notes This function is thread safe,
+    /// and does not need to synchronize once the linker is frozen.
     type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
         lookup_documentation(type_safe::optional_ref<const cppast::cpp_entity> context,
                              std::string                                       link_name) const;
 
+    /// \returns A reference to the documentation for the given link name, if there is any.
+    /// Relative link names are looked up in the given scopes.
+    /// \notes This function is thread safe,
+    /// and does not need to synchronize once the linker is frozen.
+    type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
+        lookup_documentation(const link_scopes& scopes, std::string link_name) const;
+
 private:
-    mutable std::mutex                                               mutex_;
-    mutable std::unordered_map<std::string, markup::block_reference> map_;
+    // looks up the concatenation of scope and name,
+    // where scope_hash is the hash of the scope
+    type_safe::optional<markup::block_reference> lookup(std::string_view scope,
+                                                        std::uint64_t    scope_hash,
+                                                        std::string_view name) const;
+
+    // registration is spread over multiple maps,
+    // so threads registering different names rarely block each other
+    struct shard
+    {
+        std::mutex                                               mutex;
+        std::unordered_map<std::string, markup::block_reference> map;
+    };
+    static constexpr std::size_t no_shards = 16u;
+
+    shard& get_shard(std::uint64_t hash) const noexcept
+    {
+        return shards_[hash % no_shards];
+    }
+
+    mutable std::array<shard, no_shards> shards_;
+
+    // the frozen lookup table uses open addressing with linear probing,
+    // the slots store the index of the entry plus one, zero is an empty slot
+    struct frozen_entry
+    {
+        std::uint64_t           hash;
+        std::size_t             key_begin, key_size;
+        markup::block_reference reference;
+    };
+    std::string                keys_;
+    std::vector<frozen_entry>  entries_;
+    std::vector<std::uint32_t> slots_;
 
     std::map<std::string, std::string> external_doc_;
 };
@@ -66,8 +152,8 @@ void register_documentations(const cppast::diagnostic_logger& logger, const link
 /// Resolves all unresolved links in a document.
 /// \effects For all [standardese::markup::documentation_link]() entities that are not yet resolved,
 /// uses the linker to resolve them.
-/// \notes This function is *not* thread safe and must be called after the linker is entirely
-/// populated.
+/// \notes This function must be called after the linker is entirely populated.
+/// It is thread safe as long as the same document is not resolved concurrently.
 void resolve_links(const cppast::diagnostic_logger& logger, const linker& l,
                    const markup::document_entity& document);
 } // namespace standardese
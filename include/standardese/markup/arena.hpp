@@ -0,0 +1,68 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_MARKUP_ARENA_HPP_INCLUDED
+#define STANDARDESE_MARKUP_ARENA_HPP_INCLUDED
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace standardese
+{
+namespace markup
+{
+    /// A memory arena the markup entities can be allocated from.
+    ///
+    /// While an [standardese::markup::arena_scope]() is active,
+    /// all entities created by that thread are allocated from the arena.
+    /// Deleting such an entity still runs its destructor,
+    /// but the memory is only released all at once when the arena is destroyed.
+    /// \notes The arena must outlive all entities allocated from it.
+    /// It must not be used by multiple threads at the same time.
+    class arena
+    {
+    public:
+        arena() = default;
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        /// \returns The number of bytes allocated from the arena so far.
+        std::size_t allocated() const noexcept
+        {
+            return allocated_;
+        }
+
+    private:
+        void* allocate(std::size_t size);
+
+        std::pmr::monotonic_buffer_resource resource_;
+        std::size_t                         allocated_ = 0u;
+
+        friend class entity;
+    };
+
+    /// Makes entities of the current thread allocated from an [standardese::markup::arena]().
+    ///
+    /// Scopes can be nested, the innermost one is used.
+    class arena_scope
+    {
+    public:
+        /// \effects Allocates all entities created by the current thread from `a`,
+        /// until the scope is destroyed.
+        explicit arena_scope(arena& a) noexcept;
+
+        /// \effects Restores the arena that was used before the scope was created, if any.
+        ~arena_scope() noexcept;
+
+        arena_scope(const arena_scope&) = delete;
+        arena_scope& operator=(const arena_scope&) = delete;
+
+    private:
+        arena* previous_;
+    };
+} // namespace markup
+} // namespace standardese
+
+#endif // STANDARDESE_MARKUP_ARENA_HPP_INCLUDED
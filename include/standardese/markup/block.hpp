@@ -66,7 +66,7 @@ namespace markup
         explicit block_id() : block_id("") {}
 
         /// \effects Creates it given the string representation.
-        explicit block_id(std::string id) : id_(std::move(id)) {}
+        explicit block_id(std::string id) : id_(std::move(id)), output_id_(escape(id_)) {}
 
         /// \returns Whether or not the id is empty.
         bool empty() const noexcept
@@ -81,10 +81,17 @@ namespace markup
         }
 
         /// \returns The escaped string representaton.
-        std::string as_output_str() const;
+        /// \notes It is computed once on construction,
+        /// as it is needed by every output format.
+        const std::string& as_output_str() const noexcept
+        {
+            return output_id_;
+        }
 
     private:
-        std::string id_;
+        static std::string escape(const std::string& id);
+
+        std::string id_, output_id_;
     };
 
     /// \returns Whether or not two ids are (un-)equal.
@@ -26,7 +26,12 @@ namespace markup
     };
 
     /// The `\brief` section in an entity documentation.
-    class brief_section final : public doc_section, public container_entity<phrasing_entity>
+    ///
+    /// If it is owned by a `std::shared_ptr`,
+    /// its entities can be shared by a [standardese::markup::description]().
+    class brief_section final : public doc_section,
+                                public container_entity<phrasing_entity>,
+                                public std::enable_shared_from_this<brief_section>
     {
     public:
         /// Builds a brief section.
@@ -6,6 +6,7 @@
 #define STANDARDESE_MARKUP_DOCUMENT_HPP_INCLUDED
 
 #include <utility>
+#include <vector>
 
 #include <type_safe/optional_ref.hpp>
 
@@ -16,6 +17,9 @@ namespace standardese
 {
 namespace markup
 {
+    class documentation_entity;
+    class documentation_link;
+
     /// Base class for entities representing a stand-alone document.
     ///
     /// Those are the root nodes of the markup AST.
@@ -34,16 +38,40 @@ namespace markup
             return output_name_;
         }
 
+        /// \returns All [standardese::markup::documentation_link]() entities of the document,
+        /// in the order they appear in the document.
+        /// \notes They are collected when the document is finished,
+        /// so the linker does not need to visit the entire document to resolve them.
+        const std::vector<type_safe::object_ref<const documentation_link>>& links() const noexcept
+        {
+            return links_;
+        }
+
+        /// \returns All [standardese::markup::documentation_entity]() entities of the document,
+        /// in the order they appear in the document.
+        /// \notes They are collected when the document is finished,
+        /// so the linker does not need to visit the entire document to register them.
+        const std::vector<type_safe::object_ref<const documentation_entity>>& documentations() const
+            noexcept
+        {
+            return documentations_;
+        }
+
     protected:
         document_entity(std::string title, markup::output_name name)
         : output_name_(std::move(name)), title_(std::move(title))
         {}
 
+        /// \effects Collects the links and documentations of the finished document.
+        void collect_entities();
+
     private:
         void do_visit(detail::visitor_callback_t cb, void* mem) const override;
 
-        markup::output_name output_name_;
-        std::string         title_;
+        markup::output_name                                            output_name_;
+        std::string                                                    title_;
+        std::vector<type_safe::object_ref<const documentation_link>>   links_;
+        std::vector<type_safe::object_ref<const documentation_entity>> documentations_;
     };
 
     /// A document which is the main output page of the documentation.
@@ -60,6 +88,14 @@ namespace markup
                   new main_document(std::move(title), std::move(output_name))))
             {}
 
+            /// \returns The finished document.
+            std::unique_ptr<main_document> finish()
+            {
+                auto result = container_builder::finish();
+                result->collect_entities();
+                return result;
+            }
+
             using container_builder::peek;
         };
 
@@ -87,6 +123,14 @@ namespace markup
                   new subdocument(std::move(title), std::move(output_name))))
             {}
 
+            /// \returns The finished document.
+            std::unique_ptr<subdocument> finish()
+            {
+                auto result = container_builder::finish();
+                result->collect_entities();
+                return result;
+            }
+
             using container_builder::peek;
         };
 
@@ -114,6 +158,14 @@ namespace markup
             : container_builder(std::unique_ptr<template_document>(
                   new template_document(std::move(title), std::move(file_name))))
             {}
+
+            /// \returns The finished document.
+            std::unique_ptr<template_document> finish()
+            {
+                auto result = container_builder::finish();
+                result->collect_entities();
+                return result;
+            }
         };
 
     private:
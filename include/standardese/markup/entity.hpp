@@ -5,6 +5,7 @@
 #ifndef STANDARDESE_MARKUP_ENTITY_HPP_INCLUDED
 #define STANDARDESE_MARKUP_ENTITY_HPP_INCLUDED
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -37,6 +38,14 @@ namespace markup
         entity& operator=(const entity&) = delete;
         virtual ~entity() noexcept       = default;
 
+        /// \effects Allocates memory for an entity,
+        /// from the arena of the current [standardese::markup::arena_scope]() if there is one.
+        static void* operator new(std::size_t size);
+
+        /// \effects Deallocates memory for an entity,
+        /// it does nothing if the memory was allocated from an arena.
+        static void operator delete(void* ptr) noexcept;
+
         /// \returns The kind of entity.
         entity_kind kind() const noexcept
         {
@@ -5,6 +5,8 @@
 #ifndef STANDARDESE_MARKUP_LIST_HPP_INCLUDED
 #define STANDARDESE_MARKUP_LIST_HPP_INCLUDED
 
+#include <memory>
+
 #include "phrasing.hpp"
 #include <standardese/markup/block.hpp>
 
@@ -12,6 +14,8 @@ namespace standardese
 {
 namespace markup
 {
+    class brief_section;
+
     /// The base class for all items in a list.
     class list_item_base : public block_entity
     {
@@ -97,6 +101,19 @@ namespace markup
             return builder().add_child(std::move(phrasing)).finish();
         }
 
+        /// \returns A newly built description consisting of the entities of the brief section.
+        /// \notes If the brief section is owned by a `std::shared_ptr`,
+        /// the description shares the entities with it instead of copying them,
+        /// unless they contain a [standardese::markup::documentation_link]().
+        /// The parent of shared entities is still the brief section.
+        static std::unique_ptr<description> build(const brief_section& brief);
+
+        /// \returns An iterator to the first child entity.
+        iterator begin() const noexcept;
+
+        /// \returns An iterator one past the last child entity.
+        iterator end() const noexcept;
+
     private:
         entity_kind do_get_kind() const noexcept override;
 
@@ -105,6 +122,9 @@ namespace markup
         std::unique_ptr<entity> do_clone() const override;
 
         description() = default;
+
+        // the brief section whose entities are used instead of the own children, if any
+        std::shared_ptr<const brief_section> shared_;
     };
 
     /// A list item that consists of a term and an description.
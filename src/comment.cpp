@@ -4,10 +4,12 @@
 
 #include <cassert>
 #include <algorithm>
+#include <regex>
 #include <unordered_set>
 #include <stack>
 
 #include <standardese/comment.hpp>
+#include <standardese/doc_entity.hpp>
 
 #include <cppast/cpp_friend.hpp>
 #include <cppast/cpp_namespace.hpp>
@@ -19,17 +21,28 @@ using namespace standardese;
 
 void comment_registry::merge(comment_registry&& other)
 {
-    map_.insert(std::make_move_iterator(other.map_.begin()),
-                std::make_move_iterator(other.map_.end()));
-    groups_.insert(std::make_move_iterator(other.groups_.begin()),
-                   std::make_move_iterator(other.groups_.end()));
-    modules_.insert(std::make_move_iterator(other.modules_.begin()),
-                    std::make_move_iterator(other.modules_.end()));
+    map_.merge(other.map_);
+    for (auto& group : other.groups_)
+    {
+        auto& entities = groups_[group.first];
+        entities.insert(entities.end(), group.second.begin(), group.second.end());
+    }
+    modules_.merge(other.modules_);
+
+    std::lock_guard<std::mutex> lock(unique_names_.mutex);
+    unique_names_.names.clear();
 }
 
 bool comment_registry::register_comment(type_safe::object_ref<const cppast::cpp_entity> entity,
                                         comment::doc_comment                            comment)
 {
+    if (comment.metadata().unique_name())
+    {
+        // might change the unique name of the entity and all of its children
+        std::lock_guard<std::mutex> lock(unique_names_.mutex);
+        unique_names_.names.clear();
+    }
+
     auto iter = map_.find(&*entity);
     if (iter == map_.end())
         // not in map yet
@@ -175,31 +188,199 @@ void process_inlines(const cppast::diagnostic_logger&            logger,
                            make_semantic_diagnostic(entity, "unexpected inline comment"));
         }
 }
+
+enum class line_kind
+{
+    blank,
+    text,
+    command,
+    section,
+    inline_command,
+};
+
+struct scanned_line
+{
+    line_kind             kind;
+    const char*           begin;
+    const char*           end;
+    comment::command_type command;  // if it is a command
+    bool                  has_text; // whether there is text following the command
+};
+
+std::vector<scanned_line> scan_lines(const comment::config& config, const std::string& comment)
+{
+    std::vector<scanned_line>         result;
+    std::vector<comment::any_command> candidates;
+
+    auto cur = comment.c_str();
+    auto end = cur + comment.size();
+    while (cur != end)
+    {
+        auto line_end = std::find(cur, end, '\n');
+
+        auto begin = cur;
+        while (begin != line_end && (*begin == ' ' || *begin == '\t'))
+            ++begin;
+
+        scanned_line line{begin == line_end ? line_kind::blank : line_kind::text, begin,
+                          line_end, comment::command_type::count, false};
+
+        // the first matching pattern decides, just like in the parser
+        config.get_command_candidates(begin, line_end, candidates);
+        for (auto& candidate : candidates)
+        {
+            std::cmatch match;
+            auto        matches = std::visit(
+                [&](auto command) {
+                    return std::regex_search(begin, line_end, match,
+                                             config.get_command_pattern(command),
+                                             std::regex_constants::match_continuous);
+                },
+                candidate);
+            if (matches)
+            {
+                if (auto command = std::get_if<comment::command_type>(&candidate))
+                {
+                    line.kind    = line_kind::command;
+                    line.command = *command;
+                }
+                else if (std::holds_alternative<comment::section_type>(candidate))
+                    line.kind = line_kind::section;
+                else
+                    line.kind = line_kind::inline_command;
+
+                auto rest     = begin + match.length();
+                line.has_text = std::find_if(rest, line_end, [](char c) {
+                                    return c != ' ' && c != '\t' && c != '\r';
+                                })
+                                != line_end;
+                break;
+            }
+        }
+
+        result.push_back(line);
+        cur = line_end == end ? end : line_end + 1;
+    }
+
+    return result;
+}
+
+// returns the index of the first line after the inline starting at `inline_line`,
+// the rules mirror the ones of the command extension
+std::size_t skip_inline(const std::vector<scanned_line>& lines, std::size_t inline_line)
+{
+    // a section, inline or command other than `\exclude` and `\module` ends the inline
+    auto is_explicit_end = [](const scanned_line& line) {
+        return line.kind == line_kind::section || line.kind == line_kind::inline_command
+               || (line.kind == line_kind::command
+                   && line.command != comment::command_type::exclude
+                   && line.command != comment::command_type::module);
+    };
+
+    auto end = inline_line + 1u;
+    while (end != lines.size() && !is_explicit_end(lines[end]))
+        ++end;
+    if (end != lines.size() && lines[end].kind == line_kind::command
+        && lines[end].command == comment::command_type::end)
+        // everything up to and including the `\end` belongs to the inline
+        return end + 1u;
+
+    // without an `\end`, the inline ends after its first paragraph
+    auto paragraph = lines[inline_line].has_text;
+    auto cur       = inline_line + 1u;
+    for (; cur != end; ++cur)
+        if (lines[cur].kind == line_kind::text)
+            paragraph = true;
+        else if (lines[cur].kind == line_kind::command && paragraph)
+            break;
+    return cur;
+}
+
+// returns only the lines of the comment that start with a command like `\exclude` or `\entity`,
+// the sections and inlines are dropped, including the commands belonging to an inline
+std::string get_command_lines(const comment::config& config, const std::string& comment)
+{
+    std::string result;
+
+    auto lines = scan_lines(config, comment);
+    for (auto i = std::size_t(0); i != lines.size();)
+        if (lines[i].kind == line_kind::inline_command)
+            i = skip_inline(lines, i);
+        else
+        {
+            if (lines[i].kind == line_kind::command)
+            {
+                result.append(lines[i].begin, lines[i].end);
+                result += '\n';
+            }
+            ++i;
+        }
+
+    return result;
+}
+
+// whether the entity is a member of a class, directly or indirectly,
+// the members of an excluded public base class are documented in the derived class
+bool is_class_member(const cppast::cpp_entity& entity)
+{
+    for (auto cur = entity.parent(); cur; cur = cur.value().parent())
+        if (cur.value().kind() == cppast::cpp_entity_kind::class_t)
+            return true;
+    return false;
+}
 } // namespace
 
 void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> file) const
 {
+    // one parser is used for all comments of the file
+    pooled_parser parser(*this);
+
+    // the comments are collected without locking and merged in finish()
+    file_comments result;
+    result.file_name = file->name();
+
+    // the outermost entity that is going to be excluded,
+    // the comments of its children are only scanned for commands unless they're class members
+    const cppast::cpp_entity* excluded = nullptr;
+
     // add matched comments
     cppast::visit(*file, [&](const cppast::cpp_entity& entity, const cppast::visitor_info& info) {
         if (info.event == cppast::visitor_info::container_entity_exit)
+        {
             // entity already handled
+            if (excluded == &entity)
+                excluded = nullptr;
             return true;
+        }
         else if (!cppast::is_templated(entity) && !cppast::is_friended(entity))
         {
             auto register_commented = [&](type_safe::object_ref<const cppast::cpp_entity> e,
                                           comment::doc_comment                            comment) {
-                this->register_commented(e, std::move(comment));
+                this->register_commented(result, e, std::move(comment));
             };
             auto register_uncommented = [&](type_safe::object_ref<const cppast::cpp_entity> e) {
-                this->register_uncommented(e);
+                this->register_uncommented(result, e);
             };
 
+            auto is_blacklisted
+                = blacklist_ && blacklist_.value().is_blacklisted(entity, info.access);
+            auto is_excluded = excluded != nullptr || is_blacklisted;
+
             // parse comment
             type_safe::optional<comment::parse_result> comment;
             try
             {
-                comment = type_safe::copy(entity.comment()).map([&](const std::string& str) {
-                    return comment::parse(comment::parser(config_), str, true);
+                auto text = type_safe::copy(entity.comment());
+                if (text && (is_blacklisted || (is_excluded && !is_class_member(entity))))
+                {
+                    // the documentation is not going to be used, only the commands are relevant
+                    text = get_command_lines(config_, text.value());
+                    if (text.value().empty())
+                        text = type_safe::nullopt;
+                }
+
+                comment = text.map([&](const std::string& str) {
+                    return comment::parse(*parser, str, true);
                 });
             }
             catch (comment::parse_error& ex)
@@ -227,6 +408,19 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
                 register_uncommented(type_safe::ref(entity));
 
             process_inlines(*logger_, comment, entity, register_commented, register_uncommented);
+
+            if (excluded == nullptr && info.event == cppast::visitor_info::container_entity_enter)
+            {
+                auto explicitly_excluded
+                    = result.registry.get_comment(entity)
+                          .map([](const comment::doc_comment& c) {
+                              return c.metadata().exclude() == comment::exclude_mode::entity;
+                          })
+                          .value_or(false);
+                if (is_excluded || explicitly_excluded)
+                    // all children are going to be excluded as well
+                    excluded = &entity;
+            }
         }
 
         return true;
@@ -242,22 +436,19 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
               message...));
         };
 
-        auto comment = comment::parse(comment::parser(config_), free.content, false);
+        auto comment = comment::parse(*parser, free.content, false);
         if (auto module = comment::get_module(comment.entity))
         {
-            std::unique_lock<std::mutex> lock(mutex_);
-            if (!registry_.register_comment(module.value(), std::move(comment.comment.value())))
+            if (!result.registry.register_comment(module.value(),
+                                                  std::move(comment.comment.value())))
                 log("multiple comments for module '", module.value(), "'");
         }
         else if (auto name = comment::get_remote_entity(comment.entity))
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            free_comments_.push_back(std::move(comment));
-        }
+            result.free_comments.push_back(std::move(comment));
         else if (comment::is_file(comment.entity) || config_.free_file_comments())
         {
             // comment for current file
-            if (!register_commented(file, std::move(comment.comment.value())))
+            if (!register_commented(result, file, std::move(comment.comment.value())))
                 log("multiple file comments");
         }
         else
@@ -265,38 +456,98 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
             log("comment does not have a remote entity specified");
         }
     }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.push_back(std::move(result));
+}
+
+std::unique_ptr<comment::parser> file_comment_parser::acquire_parser() const
+{
+    {
+        std::lock_guard<std::mutex> lock(parsers_mutex_);
+        if (!parsers_.empty())
+        {
+            auto result = std::move(parsers_.back());
+            parsers_.pop_back();
+            return result;
+        }
+    }
+
+    return std::unique_ptr<comment::parser>(new comment::parser(config_));
+}
+
+void file_comment_parser::release_parser(std::unique_ptr<comment::parser> parser) const noexcept
+{
+    std::lock_guard<std::mutex> lock(parsers_mutex_);
+    try
+    {
+        parsers_.push_back(std::move(parser));
+    }
+    catch (...)
+    {
+        // the pool couldn't grow, so the parser is just destroyed
+    }
 }
 
 comment_registry file_comment_parser::finish()
 {
-    resolve_free_comments();
+    // merge in a fixed order, so the result does not depend on the order the files were parsed in
+    std::stable_sort(files_.begin(), files_.end(),
+                     [](const file_comments& lhs, const file_comments& rhs) {
+                         return lhs.file_name < rhs.file_name;
+                     });
+
+    file_comments result;
+    for (auto& file : files_)
+        merge(result, std::move(file));
+    files_.clear();
+
+    resolve_free_comments(result);
     if (config_.group_uncommented())
-        group_uncommented();
-    return std::move(registry_);
+        group_uncommented(result);
+    return std::move(result.registry);
 }
 
-void file_comment_parser::resolve_free_comments()
+void file_comment_parser::merge(file_comments& result, file_comments&& file) const
+{
+    for (auto& module : file.registry.modules_)
+        if (result.registry.modules_.count(module.first) != 0u)
+            logger_->log("standardese comment",
+                         make_diagnostic(cppast::source_location::make_file(file.file_name),
+                                         "multiple comments for module '", module.first, "'"));
+
+    // the entities of different files are disjoint,
+    // so the nodes can just be moved over
+    result.registry.merge(std::move(file.registry));
+    result.uncommented.merge(file.uncommented);
+    result.free_comments.insert(result.free_comments.end(),
+                                std::make_move_iterator(file.free_comments.begin()),
+                                std::make_move_iterator(file.free_comments.end()));
+}
+
+void file_comment_parser::resolve_free_comments(file_comments& result) const
 {
     // Attach comments that are using the `\entity` command to the entity they're documenting.
-    for (auto& free : free_comments_)
+    for (auto& free : result.free_comments)
     {
         // Find all the entities that are not documented yet that match this entity command.
-        auto result = uncommented_.equal_range(comment::get_remote_entity(free.entity).value());
-        if (result.first != result.second)
+        auto range
+            = result.uncommented.equal_range(comment::get_remote_entity(free.entity).value());
+        if (range.first != range.second)
         {
             auto metadata = free.comment.value().metadata();
 
             // Assign the entire comment block to the first entity found.
-            register_commented(type_safe::ref(*result.first->second),
+            register_commented(result, type_safe::ref(*range.first->second),
                                std::move(free.comment.value()), false);
 
             // And only the metadata to all the other entities found.
             // TODO: What is an example where this actually happens? This does not show up in our test cases.
-            for (auto cur = std::next(result.first); cur != result.second; ++cur)
-                register_commented(type_safe::ref(*cur->second),
+            for (auto cur = std::next(range.first); cur != range.second; ++cur)
+                register_commented(result, type_safe::ref(*cur->second),
                                    comment::doc_comment(metadata, nullptr, {}), false);
 
-            uncommented_.erase(result.first, result.second);
+            result.uncommented.erase(range.first, range.second);
         }
         else
             logger_->log("standardese comment",
@@ -307,11 +558,11 @@ void file_comment_parser::resolve_free_comments()
     }
 }
 
-void file_comment_parser::group_uncommented()
+void file_comment_parser::group_uncommented(file_comments& result) const
 {
     // Add undocumented members to the group their preceding member is in.
     std::unordered_set<const cppast::cpp_file*> files;
-    for (const auto& uncommented : uncommented_) {
+    for (const auto& uncommented : result.uncommented) {
         const cppast::cpp_entity* file = uncommented.second;
         while (file->parent())
             file = &file->parent().value();
@@ -382,7 +633,7 @@ void file_comment_parser::group_uncommented()
                     return;
             }
 
-            auto target_comment = registry_.get_comment(target);
+            auto target_comment = result.registry.get_comment(target);
 
             if (target_comment.has_value() && target_comment.value().metadata().group())
                 // Do not implicitly assign a group if this member already has one.
@@ -392,7 +643,7 @@ void file_comment_parser::group_uncommented()
                 // Do not implicitly assign a group if this member already has some comment.
                 return;
 
-            const auto source_comment = registry_.get_comment(*source);
+            const auto source_comment = result.registry.get_comment(*source);
 
             if (!source_comment.has_value() || !source_comment.value().metadata().group().has_value())
                 // Source has no group so we cannot assign it to target.
@@ -401,7 +652,7 @@ void file_comment_parser::group_uncommented()
             comment::metadata metadata;
             metadata.set_group(source_comment.value().metadata().group().value());
 
-            register_commented(type_safe::ref(target), comment::doc_comment(metadata, nullptr, {}), false);
+            register_commented(result, type_safe::ref(target), comment::doc_comment(metadata, nullptr, {}), false);
         };
 
         cppast::visit(*file, [&](const cppast::cpp_entity& entity, const cppast::visitor_info& info) {
@@ -426,21 +677,21 @@ void file_comment_parser::group_uncommented()
     }
 }
 
-bool file_comment_parser::register_commented(type_safe::object_ref<const cppast::cpp_entity> entity,
-                                             comment::doc_comment comment, bool allow_cmd) const
+bool file_comment_parser::register_commented(
+    file_comments& result, type_safe::object_ref<const cppast::cpp_entity> entity,
+    comment::doc_comment comment, bool allow_cmd) const
 {
     auto cmd_comment = !comment.brief_section() && comment.sections().empty();
 
-    std::lock_guard<std::mutex> lock(mutex_);
     if (comment.metadata().group())
-        registry_.add_to_group(comment.metadata().group().value().name(), entity);
-    auto result = registry_.register_comment(entity, std::move(comment));
+        result.registry.add_to_group(comment.metadata().group().value().name(), entity);
+    auto registered = result.registry.register_comment(entity, std::move(comment));
 
     if (cmd_comment && allow_cmd)
         // a pure "command" comment, allow later sections
-        uncommented_.emplace(lookup_unique_name(registry_, *entity), &*entity);
+        result.uncommented.emplace(lookup_unique_name(result.registry, *entity), &*entity);
 
-    return result;
+    return registered;
 }
 
 namespace
@@ -556,8 +807,26 @@ std::string get_full_unique_name(const std::string& parent, const cppast::cpp_en
     return result;
 }
 
-template <class Lookup>
-std::string lookup_parent_unique_name(const Lookup& get_comment, const cppast::cpp_entity& e)
+} // namespace
+
+std::string comment_registry::get_default_unique_name(const cppast::cpp_entity& e) const
+{
+    {
+        std::lock_guard<std::mutex> lock(unique_names_.mutex);
+        auto                        iter = unique_names_.names.find(&e);
+        if (iter != unique_names_.names.end())
+            return iter->second;
+    }
+
+    // compute without holding the lock, it recursively needs the names of the parents
+    auto result = get_full_unique_name(get_parent_unique_name(e), e, get_unique_name(e));
+
+    std::lock_guard<std::mutex> lock(unique_names_.mutex);
+    unique_names_.names.emplace(&e, result);
+    return result;
+}
+
+std::string comment_registry::get_parent_unique_name(const cppast::cpp_entity& e) const
 {
     auto parent = e.parent();
     while (parent && (cppast::is_templated(parent.value()) || cppast::is_friended(parent.value())))
@@ -583,25 +852,13 @@ std::string lookup_parent_unique_name(const Lookup& get_comment, const cppast::c
         return result.value();
 
     // parent doesn't have a unique name
-    return get_full_unique_name(lookup_parent_unique_name(get_comment, parent.value()),
-                                parent.value(), get_unique_name(parent.value()));
+    return get_default_unique_name(parent.value());
 }
-} // namespace
 
 void file_comment_parser::register_uncommented(
-    type_safe::object_ref<const cppast::cpp_entity> entity) const
+    file_comments& result, type_safe::object_ref<const cppast::cpp_entity> entity) const
 {
-    auto unique_name
-        = get_full_unique_name(get_parent_unique_name(*entity), *entity, get_unique_name(*entity));
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    uncommented_.emplace(std::move(unique_name), &*entity);
-}
-
-std::string file_comment_parser::get_parent_unique_name(const cppast::cpp_entity& e) const
-{
-    return lookup_parent_unique_name([&](const cppast::cpp_entity& e) { return get_comment(e); },
-                                     e);
+    result.uncommented.emplace(result.registry.get_default_unique_name(*entity), &*entity);
 }
 
 std::string standardese::lookup_unique_name(const comment_registry&   registry,
@@ -611,20 +868,11 @@ std::string standardese::lookup_unique_name(const comment_registry&   registry,
     if (comment && comment.value().metadata().unique_name())
     {
         if (is_relative_unique_name(comment.value().metadata().unique_name().value()))
-        {
-            auto parent = lookup_parent_unique_name([&](const cppast::cpp_entity&
-                                                            e) { return registry.get_comment(e); },
-                                                    e);
-            return get_full_unique_name(parent, e,
+            return get_full_unique_name(registry.get_parent_unique_name(e), e,
                                         comment.value().metadata().unique_name().value().substr(1));
-        }
         else
             return comment.value().metadata().unique_name().value();
     }
 
-    // calculate unique name
-    auto parent = lookup_parent_unique_name([&](const cppast::cpp_entity&
-                                                    e) { return registry.get_comment(e); },
-                                            e);
-    return get_full_unique_name(parent, e, get_unique_name(e));
+    return registry.get_default_unique_name(e);
 }
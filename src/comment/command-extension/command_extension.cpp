@@ -4,10 +4,10 @@
 
 #include "command_extension.hpp"
 #include "user_data.hpp"
-#include "../../util/enum_values.hpp"
 
 #include <type_traits>
 #include <cassert>
+#include <variant>
 
 #include <cmark-gfm.h>
 #include <cmark-gfm-extension_api.h>
@@ -111,7 +111,13 @@ cmark_node* command_extension::cmark_postprocess(cmark_syntax_extension* extensi
 
     self.postprocessing = true;
 
-    return self.postprocess(root);
+    auto* result = self.postprocess(root);
+
+    // cmark resets the parser once a document has been finished, so the same
+    // parser (and this extension) can be used for the next comment.
+    self.postprocessing = false;
+
+    return result;
 }
 
 cmark_node* command_extension::postprocess(cmark_node* root) const
@@ -536,18 +542,12 @@ cmark_node* command_extension::parse_command(cmark_parser* parser, cmark_node* p
         return node;
     };
 
-    // We inefficiently, try to match every command regex here. This could be
-    // done much more efficiently, e.g., by discarding any leading characters
-    // that fail to produce a partial match. But presumably, constructing the
-    // C++ AST in the first place is the relevant bottleneck anyway.
-    for (const auto command : enum_values<command_type>())
-        if (cmark_node* node = parse_command(command))
-            return node;
-    for (const auto command : enum_values<section_type>())
-        if (cmark_node* node = parse_command(command))
-            return node;
-    for (const auto command : enum_values<inline_type>())
-        if (cmark_node* node = parse_command(command))
+    // Only try the regexes of commands that could match at all. For the
+    // default patterns this is decided by the name of the command, so
+    // usually at most one regex is tried at every block start.
+    config_.get_command_candidates(reinterpret_cast<const char*>(begin), reinterpret_cast<const char*>(end), candidates_);
+    for (const auto& candidate : candidates_)
+        if (cmark_node* node = std::visit(parse_command, candidate))
             return node;
 
     return nullptr;
@@ -8,6 +8,7 @@
 
 #include <optional>
 #include <functional>
+#include <vector>
 
 #include <cmark-gfm.h>
 
@@ -137,6 +138,9 @@ namespace standardese::comment::command_extension
         /// The underlying cmark extension that provides the C interface to this class.
         cmark_syntax_extension* extension_;
 
+        /// The commands that are tried by [*parse_command](), reused to avoid allocations.
+        std::vector<any_command> candidates_;
+
         /// Whether the postprocessing has started already.
         /// \see [*cmark_can_contain]() for why we need to keep track of this.
         bool postprocessing = false;
@@ -6,6 +6,8 @@
 #include <standardese/comment/config.hpp>
 #include <stdexcept>
 #include <cassert>
+#include <cctype>
+#include <optional>
 
 #include "../util/enum_values.hpp"
 
@@ -77,7 +79,7 @@ std::string config::default_command_pattern(char command_character, inline_type
     return prefix + command_name(cmd) + boundary + word;
 }
 
-config::config(const options& options) : free_file_comments_(options.free_file_comments), group_uncommented_(options.group_uncommented)
+config::config(const options& options) : command_character_(options.command_character), free_file_comments_(options.free_file_comments), group_uncommented_(options.group_uncommented)
 {
     const auto pattern = [&](const auto command) {
         const std::string name = command_name(command);
@@ -89,6 +91,13 @@ config::config(const options& options) : free_file_comments_(options.free_file_c
             if (specification.rfind(name, 0) != std::string::npos)
                 parameters.emplace_back(specification);
 
+        // Only the default pattern can be found by looking at the command
+        // name, anything else has to be tried with the regular expression.
+        if (parameters.size() == 1)
+            default_commands_.emplace(command_name(command), command);
+        else
+            custom_commands_.emplace_back(command);
+
         return command_pattern(parameters);
     };
 
@@ -231,6 +240,44 @@ const std::regex& config::get_command_pattern(inline_type type) const
     return inline_command_patterns_[unsigned(type)];
 }
 
+void config::get_command_candidates(const char* begin, const char* end, std::vector<any_command>& result) const
+{
+    result.clear();
+
+    // All default patterns are the command character followed by the name of
+    // the command and whitespace, so the name determines the only command
+    // that could possibly match.
+    std::optional<any_command> named;
+    if (begin != end && *begin == command_character_)
+    {
+        const auto is_name_char = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        };
+
+        auto name_end = begin + 1;
+        while (name_end != end && is_name_char(*name_end))
+            ++name_end;
+
+        auto iter = default_commands_.find(std::string_view(begin + 1, std::size_t(name_end - begin - 1)));
+        if (iter != default_commands_.end())
+            named = iter->second;
+    }
+
+    // Merge the named command into the custom ones to keep the order in which
+    // the patterns were tried originally.
+    for (const auto& command : custom_commands_)
+    {
+        if (named && *named < command)
+        {
+            result.push_back(*named);
+            named.reset();
+        }
+        result.push_back(command);
+    }
+    if (named)
+        result.push_back(*named);
+}
+
 const char* config::inline_section_name(section_type section) const
 {
     switch (section)
@@ -229,6 +229,7 @@ public:
 
     std::unique_ptr<markup::code_block> finish()
     {
+        flush_text();
         return builder_.finish();
     }
 
@@ -355,19 +356,19 @@ private:
     void do_write_token_seq(cppast::string_view tokens) override
     {
         update_indent();
-        builder_.add_child(markup::text::build(tokens.c_str()));
+        text_.append(tokens.c_str(), tokens.length());
     }
 
     void do_write_keyword(cppast::string_view keyword) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::keyword::build(keyword.c_str()));
+        add_child(markup::code_block::keyword::build(keyword.c_str()));
     }
 
     void write_identifier(cppast::string_view identifier)
     {
         if (identifier.length() > 0u)
-            builder_.add_child(markup::code_block::identifier::build(identifier.c_str()));
+            add_child(markup::code_block::identifier::build(identifier.c_str()));
     }
 
     bool write_link(const doc_entity& entity, cppast::string_view name)
@@ -377,7 +378,7 @@ private:
             // only generate link if the entity has actual documentation
             markup::documentation_link::builder link(entity.link_name());
             link.add_child(markup::code_block::identifier::build(name.c_str()));
-            builder_.add_child(link.finish());
+            add_child(link.finish());
         }
         else if (entity.is_excluded())
         {
@@ -429,37 +430,37 @@ private:
     void do_write_punctuation(cppast::string_view punct) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::punctuation::build(punct.c_str()));
+        add_child(markup::code_block::punctuation::build(punct.c_str()));
     }
 
     void do_write_str_literal(cppast::string_view str) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::string_literal::build(str.c_str()));
+        add_child(markup::code_block::string_literal::build(str.c_str()));
     }
 
     void do_write_int_literal(cppast::string_view str) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::int_literal::build(str.c_str()));
+        add_child(markup::code_block::int_literal::build(str.c_str()));
     }
 
     void do_write_float_literal(cppast::string_view str) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::float_literal::build(str.c_str()));
+        add_child(markup::code_block::float_literal::build(str.c_str()));
     }
 
     void do_write_preprocessor(cppast::string_view punct) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::preprocessor::build(punct.c_str()));
+        add_child(markup::code_block::preprocessor::build(punct.c_str()));
     }
 
     void write_excluded()
     {
         update_indent();
-        builder_.add_child(markup::code_block::identifier::build(config_->hidden_name()));
+        add_child(markup::code_block::identifier::build(config_->hidden_name()));
     }
 
     void do_write_excluded(const cppast::cpp_entity&) override
@@ -469,26 +470,43 @@ private:
 
     void do_write_newline() override
     {
-        builder_.add_child(markup::soft_break::build());
+        add_child(markup::soft_break::build());
         need_indent_.set();
     }
 
     void do_write_whitespace() override
     {
         update_indent();
-        builder_.add_child(markup::text::build(" "));
+        text_ += ' ';
     }
 
     void update_indent()
     {
         if (need_indent_.try_reset())
-            builder_.add_child(markup::text::build(std::string(level_, ' ')));
+            text_.append(level_, ' ');
+    }
+
+    void add_child(std::unique_ptr<markup::phrasing_entity> child)
+    {
+        flush_text();
+        builder_.add_child(std::move(child));
+    }
+
+    void flush_text()
+    {
+        if (!text_.empty())
+        {
+            builder_.add_child(markup::text::build(text_));
+            text_.clear();
+        }
     }
 
     type_safe::object_ref<const synopsis_config>          config_;
     type_safe::object_ref<const cppast::cpp_entity_index> index_;
 
     markup::code_block::builder builder_;
+    // consecutive plain text, indentation and whitespace is added as a single text entity
+    std::string text_;
 
     std::stack<type_safe::object_ref<const cppast::cpp_entity>> entities_;
 
@@ -777,13 +795,9 @@ std::unique_ptr<markup::term_description_item> get_inline_doc(
     if (comment && comment.value().brief_section())
     {
         auto term = markup::term::build(markup::code::build(get_entity_name(false, e)));
-
-        markup::description::builder description;
-        for (auto& phrasing : comment.value().brief_section().value())
-            description.add_child(markup::clone(phrasing));
-
         return markup::term_description_item::build(std::move(id), std::move(term),
-                                                    description.finish());
+                                                    markup::description::build(
+                                                        comment.value().brief_section().value()));
     }
     else
         return nullptr;
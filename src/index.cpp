@@ -6,6 +6,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <iterator>
+#include <thread>
 #include <cppast/cpp_file.hpp>
 #include <cppast/cpp_namespace.hpp>
 #include <cppast/cpp_preprocessor.hpp>
@@ -24,18 +27,28 @@ using namespace standardese;
 
 void entity_index::insert(entity e) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto                        range
-        = std::equal_range(entities_.begin(), entities_.end(), e,
-                           [](const entity_index::entity& lhs, const entity_index::entity& rhs) {
-                               return lhs.scope + lhs.name < rhs.scope + rhs.name;
-                           });
-    if (range.first == range.second)
-        entities_.insert(range.first, std::move(e));
-    else
+    auto& bucket = buckets_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % no_buckets];
+    std::lock_guard<std::mutex> lock(bucket.mutex);
+    bucket.entities.push_back(std::move(e));
+}
+
+std::vector<entity_index::entity> entity_index::sorted_entities() const
+{
+    std::vector<entity> result;
+    for (auto& bucket : buckets_)
     {
-        assert(std::next(range.first) == range.second);
-        auto& inserted = *range.first;
+        std::lock_guard<std::mutex> lock(bucket.mutex);
+        result.insert(result.end(), std::make_move_iterator(bucket.entities.begin()),
+                      std::make_move_iterator(bucket.entities.end()));
+        bucket.entities.clear();
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+                     [](const entity& lhs, const entity& rhs) { return lhs.key < rhs.key; });
+
+    // merge duplicates: the first one wins,
+    // unless it is a namespace without documentation and a later one has documentation
+    auto merge = [](entity& inserted, entity& e) {
         if (auto builder = inserted.doc.optional_value(
                 type_safe::variant_type<markup::namespace_documentation::builder>{}))
         {
@@ -44,7 +57,22 @@ void entity_index::insert(entity e) const
             if (!builder.value().has_documentation() && e_builder.has_documentation())
                 inserted.doc = std::move(e.doc);
         }
+    };
+
+    auto last = result.begin();
+    for (auto cur = result.begin(); cur != result.end(); ++cur)
+    {
+        if (cur == last)
+            continue;
+        else if (cur->key == last->key)
+            merge(*last, *cur);
+        else if (++last != cur)
+            *last = std::move(*cur);
     }
+    if (last != result.end())
+        result.erase(std::next(last), result.end());
+
+    return result;
 }
 
 namespace
@@ -59,14 +87,9 @@ std::unique_ptr<markup::entity_index_item> get_entity_entry(
     auto term = markup::term::build(std::move(link));
 
     if (brief)
-    {
-        markup::description::builder description;
-        for (auto& child : brief.value())
-            description.add_child(markup::clone(child));
-
         return markup::entity_index_item::build(markup::block_id(std::move(link_name)),
-                                                std::move(term), description.finish());
-    }
+                                                std::move(term),
+                                                markup::description::build(brief.value()));
     else
         return markup::entity_index_item::build(markup::block_id(std::move(link_name)),
                                                 std::move(term));
@@ -152,6 +175,16 @@ struct nested_list_builder
         type_safe::with(builder, lambda{}, std::move(item));
     }
 };
+
+// whether or not the entity scope is the scope of the namespace, i.e. `<namespace>::`
+bool is_parent_scope(const std::string& ns, std::string_view entity_scope)
+{
+    if (ns.empty())
+        return entity_scope.empty();
+    return entity_scope.size() == ns.size() + 2u
+           && entity_scope.compare(0, ns.size(), ns) == 0
+           && entity_scope.substr(ns.size()) == "::";
+}
 } // namespace
 
 std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
@@ -162,11 +195,10 @@ std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
     std::vector<nested_list_builder> lists;
     lists.push_back(nested_list_builder{"", type_safe::ref(builder)});
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    for (auto& entity : entities_)
+    for (auto& entity : sorted_entities())
     {
         // find matching parent
-        while (entity.scope != (lists.back().scope.empty() ? "" : lists.back().scope + "::"))
+        while (!is_parent_scope(lists.back().scope, entity.scope()))
         {
             auto ns = std::move(lists.back());
             lists.pop_back();
@@ -176,13 +208,12 @@ std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
         if (auto ns = entity.doc.optional_value(
                 type_safe::variant_type<markup::namespace_documentation::builder>{}))
             // we've got a namespace
-            lists.push_back(nested_list_builder{entity.scope + entity.name, std::move(ns.value())});
+            lists.push_back(nested_list_builder{std::move(entity.key), std::move(ns.value())});
         else
             // normal entity
             lists.back().add_item(std::move(entity.doc.value(
                 type_safe::variant_type<std::unique_ptr<markup::entity_index_item>>{})));
     }
-    lock.unlock();
 
     while (!lists.empty())
     {
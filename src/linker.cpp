@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <functional>
 
 #include <cppast/cpp_entity.hpp>
 #include <cppast/cpp_file.hpp>
@@ -95,45 +97,135 @@ std::string short_link_name(const std::string& name)
 
     return result;
 }
+
+// FNV-1a, which can be continued to hash the concatenation of strings
+constexpr std::uint64_t link_name_hash_basis = 14695981039346656037ull;
+
+std::uint64_t hash_link_name(std::string_view name,
+                             std::uint64_t    hash = link_name_hash_basis) noexcept
+{
+    for (auto c : name)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
 } // namespace
 
 bool linker::register_documentation(std::string link_name, const markup::document_entity& document,
                                     const markup::block_id& documentation, bool force) const
 {
+    assert(!is_frozen() && "cannot register documentation in a frozen linker");
+
     auto ref = markup::block_reference(document.output_name(), documentation);
 
     link_name       = process_link_name(std::move(link_name));
     auto short_name = short_link_name(link_name);
 
-    std::lock_guard<std::mutex> lock(mutex_);
-
     // insert long name
-    auto result = map_.emplace(std::move(link_name), ref);
-    if (!result.second) // not inserted
     {
-        if (force)
-            result.first->second = ref; // override anyway
-        else
-            return false;
+        auto&                       long_shard = get_shard(hash_link_name(link_name));
+        std::lock_guard<std::mutex> lock(long_shard.mutex);
+
+        auto result = long_shard.map.emplace(link_name, ref);
+        if (!result.second) // not inserted
+        {
+            if (force)
+                result.first->second = ref; // override anyway
+            else
+                return false;
+        }
     }
 
     // insert short name
-    if (short_name != result.first->first)
+    if (short_name != link_name)
     {
-        result = map_.emplace(std::move(short_name), ref);
+        auto&                       short_shard = get_shard(hash_link_name(short_name));
+        std::lock_guard<std::mutex> lock(short_shard.mutex);
+
+        auto result = short_shard.map.emplace(std::move(short_name), ref);
         if (!result.second)
         {
             if (force)
                 result.first->second = std::move(ref);
             else
                 // duplicate, erase first one as well
-                map_.erase(result.first);
+                short_shard.map.erase(result.first);
         }
     }
 
     return true;
 }
 
+void linker::freeze()
+{
+    assert(!is_frozen());
+
+    auto size = std::size_t(0);
+    for (auto& shard : shards_)
+        size += shard.map.size();
+
+    // keep the load factor below one half
+    auto no_slots = std::size_t(16u);
+    while (no_slots < 2 * size)
+        no_slots *= 2;
+    slots_.assign(no_slots, 0u);
+    entries_.reserve(size);
+
+    for (auto& shard : shards_)
+    {
+        for (auto& entry : shard.map)
+        {
+            auto hash = hash_link_name(entry.first);
+            entries_.push_back({hash, keys_.size(), entry.first.size(), std::move(entry.second)});
+            keys_ += entry.first;
+
+            auto slot = hash & (no_slots - 1u);
+            while (slots_[slot] != 0u)
+                slot = (slot + 1u) & (no_slots - 1u);
+            slots_[slot] = std::uint32_t(entries_.size());
+        }
+
+        shard.map.clear();
+    }
+}
+
+type_safe::optional<markup::block_reference> linker::lookup(std::string_view scope,
+                                                            std::uint64_t    scope_hash,
+                                                            std::string_view name) const
+{
+    auto hash = hash_link_name(name, scope_hash);
+    if (is_frozen())
+    {
+        auto mask = slots_.size() - 1u;
+        for (auto slot = hash & mask; slots_[slot] != 0u; slot = (slot + 1u) & mask)
+        {
+            auto& entry = entries_[slots_[slot] - 1u];
+            if (entry.hash != hash || entry.key_size != scope.size() + name.size())
+                continue;
+
+            auto key = std::string_view(keys_).substr(entry.key_begin, entry.key_size);
+            if (key.substr(0, scope.size()) == scope && key.substr(scope.size()) == name)
+                return entry.reference;
+        }
+        return type_safe::nullopt;
+    }
+    else
+    {
+        auto key = std::string(scope);
+        key += name;
+
+        auto&                       shard = get_shard(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end())
+            return type_safe::nullopt;
+        return iter->second;
+    }
+}
+
 namespace
 {
 bool has_scope(const std::string& str, const std::string& scope)
@@ -164,36 +256,52 @@ std::string get_scope_name(const cppast::cpp_entity& entity)
     return type_safe::copy(scope_name).value_or("");
 }
 
-std::string get_entity_scope(const cppast::cpp_entity& entity)
+} // namespace
+
+link_scopes::link_scopes(type_safe::optional_ref<const cppast::cpp_entity> context)
 {
-    std::string result;
-    for (auto cur = entity.parent(); cur; cur = cur.value().parent())
+    std::vector<const cppast::cpp_entity*> entities;
+    for (auto cur = context; cur; cur = cur.value().parent())
+        entities.push_back(&cur.value());
+
+    // the scope of an entity consists of the scope names of all parents,
+    // so build it starting at the root
+    prefixes_.resize(entities.size());
+    auto hash = link_name_hash_basis;
+    for (auto i = entities.size(); i-- > 0u;)
     {
-        auto cur_scope = get_scope_name(cur.value());
-        if (!cur_scope.empty())
-            result = cur_scope + "::" + result;
+        prefixes_[i] = {scope_.size(), hash};
+
+        auto scope_name = get_scope_name(*entities[i]);
+        if (!scope_name.empty())
+        {
+            // link names don't contain whitespace
+            for (auto c : scope_name)
+                if (c != ' ')
+                    scope_ += c;
+            scope_ += "::";
+            hash = hash_link_name(std::string_view(scope_).substr(prefixes_[i].length), hash);
+        }
     }
-    return result;
 }
-} // namespace
 
 type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
     lookup_documentation(type_safe::optional_ref<const cppast::cpp_entity> context,
                          std::string                                       link_name) const
+{
+    if (is_relative(link_name))
+        return lookup_documentation(link_scopes(context), std::move(link_name));
+    else
+        // no need to compute the scopes
+        return lookup_documentation(link_scopes(nullptr), std::move(link_name));
+}
+
+type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
+    lookup_documentation(const link_scopes& scopes, std::string link_name) const
 {
     auto relative = is_relative(link_name);
     link_name     = process_link_name(std::move(link_name));
 
-    // performs local lookup
-    auto do_lookup = [&](const std::string& link_name)
-        -> type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto                        iter = map_.find(process_link_name(link_name));
-        if (iter == map_.end())
-            return type_safe::nullvar;
-        return iter->second;
-    };
-
     auto external_iter = external_doc_.lower_bound(link_name);
     if (external_iter != external_doc_.begin()
         && has_scope(link_name, std::prev(external_iter)->first))
@@ -203,19 +311,19 @@ type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> l
         return get_url(external_iter->second, link_name);
     }
     else if (!relative)
+    {
         // absolute lookup
-        return do_lookup(link_name);
+        if (auto result = lookup("", link_name_hash_basis, link_name))
+            return result.value();
+        return type_safe::nullvar;
+    }
     else
     {
-        // relative lookup
-        while (context)
-        {
-            if (auto result = do_lookup(get_entity_scope(context.value()) + link_name))
-                return result;
-
-            // go to parent
-            context = context.value().parent();
-        }
+        // relative lookup, starting in the scope of the context and going up to the parents
+        for (auto& prefix : scopes.prefixes_)
+            if (auto result = lookup(std::string_view(scopes.scope_).substr(0, prefix.length),
+                                     prefix.hash, link_name))
+                return result.value();
 
         return type_safe::nullvar;
     }
@@ -227,14 +335,15 @@ template <class FileVisitor, class DocVisitor>
 void visit_documentations(const markup::document_entity& document, const FileVisitor& file_visitor,
                           const DocVisitor& doc_visitor)
 {
-    markup::visit(document, [&](const markup::entity& e) {
-        if (e.kind() == markup::entity_kind::file_documentation)
-            file_visitor(static_cast<const markup::file_documentation&>(e));
-        else if (e.kind() == markup::entity_kind::namespace_documentation
-                 || e.kind() == markup::entity_kind::module_documentation)
+    for (auto& doc : document.documentations())
+    {
+        if (doc->kind() == markup::entity_kind::file_documentation)
+            file_visitor(static_cast<const markup::file_documentation&>(*doc));
+        else if (doc->kind() == markup::entity_kind::namespace_documentation
+                 || doc->kind() == markup::entity_kind::module_documentation)
             // note: no need to handle entity_documentation
-            doc_visitor(static_cast<const markup::documentation_entity&>(e));
-    });
+            doc_visitor(*doc);
+    }
 }
 
 bool is_injected(const doc_entity& doc_e)
@@ -386,35 +495,50 @@ void standardese::resolve_links(const cppast::diagnostic_logger& logger, const l
         return markup::block_id();
     };
 
-    type_safe::optional_ref<const cppast::cpp_entity> context;
-    markup::visit(document, [&](const markup::entity& entity) {
-        if (entity.kind() == markup::entity_kind::documentation_link)
+    // the innermost documentation providing the context of a link
+    auto get_context_documentation = [&](const markup::entity& link) -> const markup::entity* {
+        for (auto cur = link.parent(); cur; cur = cur.value().parent())
+            if (get_context(cur.value()))
+                return &cur.value();
+        return nullptr;
+    };
+
+    const markup::entity* context = nullptr;
+    // scopes of the current context, only computed once per context when needed
+    type_safe::optional<link_scopes> scopes;
+    for (auto& link : document.links())
+    {
+        auto unresolved = link->unresolved_destination();
+        if (!unresolved)
+            continue;
+
+        auto link_context = get_context_documentation(*link);
+        if (!scopes || link_context != context)
         {
-            auto& link = static_cast<const markup::documentation_link&>(entity);
-            if (auto unresolved = link.unresolved_destination())
-            {
-                auto destination = l.lookup_documentation(context, unresolved.value());
-                if (auto block = destination.optional_value(
-                        type_safe::variant_type<markup::block_reference>{}))
-                {
-                    auto same_document = !block.value().document()
-                                         || block.value().document().value().name()
-                                                == document.output_name().name();
-                    if (!same_document
-                        || block.value().id().as_str() != get_documentation_block(entity).as_str())
-                        // only resolve if points to something different
-                        link.resolve_destination(block.value());
-                }
-                else if (auto url
-                         = destination.optional_value(type_safe::variant_type<markup::url>{}))
-                    link.resolve_destination(url.value());
-                else
-                    logger.log("standardese linker",
-                               make_diagnostic(get_location(document, link),
-                                               "unresolved link name '", unresolved.value(), '\''));
-            }
+            context = link_context;
+            if (context)
+                scopes.emplace(get_context(*context));
+            else
+                scopes.emplace(nullptr);
         }
-        else if (auto new_context = get_context(entity))
-            context = new_context;
-    });
+
+        auto destination = l.lookup_documentation(scopes.value(), unresolved.value());
+        if (auto block
+            = destination.optional_value(type_safe::variant_type<markup::block_reference>{}))
+        {
+            auto same_document = !block.value().document()
+                                 || block.value().document().value().name()
+                                        == document.output_name().name();
+            if (!same_document
+                || block.value().id().as_str() != get_documentation_block(*link).as_str())
+                // only resolve if points to something different
+                link->resolve_destination(block.value());
+        }
+        else if (auto url = destination.optional_value(type_safe::variant_type<markup::url>{}))
+            link->resolve_destination(url.value());
+        else
+            logger.log("standardese linker",
+                       make_diagnostic(get_location(document, *link), "unresolved link name '",
+                                       unresolved.value(), '\''));
+    }
 }
@@ -0,0 +1,66 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/arena.hpp>
+
+#include <new>
+
+#include <standardese/markup/entity.hpp>
+
+using namespace standardese::markup;
+
+namespace
+{
+thread_local arena* current_arena = nullptr;
+
+// every entity is prefixed by a header that stores whether it was allocated from an arena,
+// as entities might be deleted after the scope or by a different thread
+struct allocation_header
+{
+    bool from_arena;
+};
+
+constexpr auto header_size = alignof(std::max_align_t);
+static_assert(sizeof(allocation_header) <= header_size, "header too big");
+
+allocation_header& get_header(void* memory) noexcept
+{
+    return *static_cast<allocation_header*>(memory);
+}
+} // namespace
+
+void* arena::allocate(std::size_t size)
+{
+    allocated_ += size;
+    return resource_.allocate(size, alignof(std::max_align_t));
+}
+
+arena_scope::arena_scope(arena& a) noexcept : previous_(current_arena)
+{
+    current_arena = &a;
+}
+
+arena_scope::~arena_scope() noexcept
+{
+    current_arena = previous_;
+}
+
+void* entity::operator new(std::size_t size)
+{
+    auto memory = current_arena ? current_arena->allocate(header_size + size)
+                                : ::operator new(header_size + size);
+    ::new (memory) allocation_header{current_arena != nullptr};
+    return static_cast<char*>(memory) + header_size;
+}
+
+void entity::operator delete(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    auto memory = static_cast<char*>(ptr) - header_size;
+    if (!get_header(memory).from_arena)
+        ::operator delete(memory);
+    // memory of an arena is released when the arena is destroyed
+}
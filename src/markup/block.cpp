@@ -31,11 +31,11 @@ void escape_char(std::string& str, char c)
 }
 } // namespace
 
-std::string block_id::as_output_str() const
+std::string block_id::escape(const std::string& id)
 {
-    std::string id;
-    id.reserve(id_.size());
-    for (auto c : id_)
-        escape_char(id, c);
-    return id;
+    std::string result;
+    result.reserve(id.size());
+    for (auto c : id)
+        escape_char(result, c);
+    return result;
 }
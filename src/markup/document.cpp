@@ -6,10 +6,25 @@
 
 #include <fstream>
 
+#include <standardese/markup/documentation.hpp>
 #include <standardese/markup/entity_kind.hpp>
+#include <standardese/markup/link.hpp>
+#include <standardese/markup/visitor.hpp>
 
 using namespace standardese::markup;
 
+void document_entity::collect_entities()
+{
+    links_.clear();
+    documentations_.clear();
+    visit(*this, [&](const entity& e) {
+        if (e.kind() == entity_kind::documentation_link)
+            links_.push_back(type_safe::ref(static_cast<const documentation_link&>(e)));
+        else if (is_documentation(e.kind()))
+            documentations_.push_back(type_safe::ref(static_cast<const documentation_entity&>(e)));
+    });
+}
+
 void document_entity::do_visit(detail::visitor_callback_t cb, void* mem) const
 {
     for (auto& child : *this)
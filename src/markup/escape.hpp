@@ -5,9 +5,10 @@
 #ifndef STANDARDESE_MARKUP_ESCAPE_HPP_INCLUDED
 #define STANDARDESE_MARKUP_ESCAPE_HPP_INCLUDED
 
-#include <cstdio>
-#include <cstring>
+#include <array>
+#include <cstddef>
 #include <ostream>
+#include <string>
 
 namespace standardese
 {
@@ -15,60 +16,135 @@ namespace markup
 {
     namespace detail
     {
-        inline void write_html_text(std::ostream& out, const char* str)
+        // the replacement of a character, empty if it doesn't need escaping
+        struct escape_entry
         {
-            // implements rule 1 here:
-            // https://www.owasp.org/index.php/XSS_(Cross_Site_Scripting)_Prevention_Cheat_Sheet
-            for (auto ptr = str; *ptr; ++ptr)
+            char          str[7];
+            unsigned char size;
+        };
+
+        using escape_table = std::array<escape_entry, 256>;
+
+        constexpr escape_entry make_escape_entry(const char* str)
+        {
+            escape_entry result{};
+            while (str[result.size])
             {
-                auto c = *ptr;
-                if (c == '&')
-                    out << "&amp;";
-                else if (c == '<')
-                    out << "&lt;";
-                else if (c == '>')
-                    out << "&gt;";
-                else if (c == '"')
-                    out << "&quot;";
-                else if (c == '\'')
-                    out << "&#x27;";
-                else if (c == '/')
-                    out << "&#x2F;";
-                else
-                    out << c;
+                result.str[result.size] = str[result.size];
+                ++result.size;
             }
+            return result;
         }
 
-        inline bool needs_url_escaping(char c)
+        // implements rule 1 here:
+        // https://www.owasp.org/index.php/XSS_(Cross_Site_Scripting)_Prevention_Cheat_Sheet
+        inline constexpr escape_table html_text_table = [] {
+            escape_table table{};
+            table['&']  = make_escape_entry("&amp;");
+            table['<']  = make_escape_entry("&lt;");
+            table['>']  = make_escape_entry("&gt;");
+            table['"']  = make_escape_entry("&quot;");
+            table['\''] = make_escape_entry("&#x27;");
+            table['/']  = make_escape_entry("&#x2F;");
+            return table;
+        }();
+
+        inline constexpr escape_table xml_text_table = [] {
+            escape_table table{};
+            table['&']  = make_escape_entry("&amp;");
+            table['<']  = make_escape_entry("&lt;");
+            table['>']  = make_escape_entry("&gt;");
+            table['"']  = make_escape_entry("&quot;");
+            table['\''] = make_escape_entry("&apos;");
+            return table;
+        }();
+
+        constexpr bool is_safe_url_char(char c)
         {
             // don't escape reserved URL characters
             // don't escape safe URL characters
-            char safe[] = "-_.+!*(),%#@?=;:/,+$"
-                          "0123456789"
-                          "abcdefghijklmnopqrstuvwxyz"
-                          "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-            return std::strchr(safe, c) == nullptr;
+            constexpr const char safe[] = "-_.+!*(),%#@?=;:/,+$"
+                                          "0123456789"
+                                          "abcdefghijklmnopqrstuvwxyz"
+                                          "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+            for (auto ptr = safe; *ptr; ++ptr)
+                if (*ptr == c)
+                    return true;
+            return false;
         }
 
-        inline void write_html_url(std::ostream& out, const char* url)
-        {
-            for (auto ptr = url; *ptr; ++ptr)
+        inline constexpr escape_table html_url_table = [] {
+            constexpr const char hex[] = "0123456789ABCDEF";
+
+            escape_table table{};
+            for (auto c = 1u; c != table.size(); ++c)
             {
-                auto c = *ptr;
                 if (c == '&')
-                    out << "&amp;";
+                    table[c] = make_escape_entry("&amp;");
                 else if (c == '\'')
-                    out << "&#x27";
-                else if (needs_url_escaping(c))
+                    table[c] = make_escape_entry("&#x27");
+                else if (!is_safe_url_char(static_cast<char>(c)))
+                {
+                    table[c].str[0] = '%';
+                    table[c].str[1] = hex[c / 16u];
+                    table[c].str[2] = hex[c % 16u];
+                    table[c].size   = 3u;
+                }
+            }
+            return table;
+        }();
+
+        // writes the escaped string by passing the unescaped runs and the replacements to the
+        // sink, instead of writing it character by character
+        template <typename Sink>
+        void write_escaped(const escape_table& table, const char* str, Sink&& sink)
+        {
+            auto run = str;
+            auto ptr = str;
+            for (; *ptr; ++ptr)
+            {
+                auto& entry = table[static_cast<unsigned char>(*ptr)];
+                if (entry.size != 0u)
                 {
-                    char buf[3];
-                    std::snprintf(buf, 3, "%02X", unsigned(c));
-                    out << "%";
-                    out << buf;
+                    if (run != ptr)
+                        sink(run, std::size_t(ptr - run));
+                    sink(entry.str, std::size_t(entry.size));
+                    run = ptr + 1;
                 }
-                else
-                    out << c;
             }
+            if (run != ptr)
+                sink(run, std::size_t(ptr - run));
+        }
+
+        inline void write_escaped(std::ostream& out, const escape_table& table, const char* str)
+        {
+            write_escaped(table, str, [&](const char* begin, std::size_t size) {
+                out.write(begin, std::streamsize(size));
+            });
+        }
+
+        inline void write_escaped(std::string& out, const escape_table& table, const char* str)
+        {
+            write_escaped(table, str,
+                          [&](const char* begin, std::size_t size) { out.append(begin, size); });
+        }
+
+        template <typename Out>
+        void write_html_text(Out& out, const char* str)
+        {
+            write_escaped(out, html_text_table, str);
+        }
+
+        template <typename Out>
+        void write_xml_text(Out& out, const char* str)
+        {
+            write_escaped(out, xml_text_table, str);
+        }
+
+        template <typename Out>
+        void write_html_url(Out& out, const char* url)
+        {
+            write_escaped(out, html_url_table, url);
         }
     } // namespace detail
 } // namespace markup
@@ -4,7 +4,9 @@
 
 #include <standardese/markup/list.hpp>
 
+#include <standardese/markup/doc_section.hpp>
 #include <standardese/markup/entity_kind.hpp>
+#include <standardese/markup/visitor.hpp>
 
 using namespace standardese::markup;
 
@@ -51,6 +53,47 @@ entity_kind description::do_get_kind() const noexcept
     return entity_kind::description;
 }
 
+namespace
+{
+bool contains_link(const brief_section& brief)
+{
+    auto result = false;
+    visit(brief, [&](const entity& e) {
+        if (e.kind() == entity_kind::documentation_link)
+            result = true;
+    });
+    return result;
+}
+} // namespace
+
+std::unique_ptr<description> description::build(const brief_section& brief)
+{
+    // documentation links are resolved in place by each document,
+    // so they can't be shared between documents
+    auto shared = brief.weak_from_this().lock();
+    if (shared && !contains_link(brief))
+    {
+        std::unique_ptr<description> result(new description);
+        result->shared_ = std::move(shared);
+        return result;
+    }
+
+    builder b;
+    for (auto& child : brief)
+        b.add_child(detail::unchecked_downcast<phrasing_entity>(child.clone()));
+    return b.finish();
+}
+
+description::iterator description::begin() const noexcept
+{
+    return shared_ ? shared_->begin() : container_entity::begin();
+}
+
+description::iterator description::end() const noexcept
+{
+    return shared_ ? shared_->end() : container_entity::end();
+}
+
 void description::do_visit(detail::visitor_callback_t cb, void* mem) const
 {
     for (auto& child : *this)
@@ -59,6 +102,13 @@ void description::do_visit(detail::visitor_callback_t cb, void* mem) const
 
 std::unique_ptr<entity> description::do_clone() const
 {
+    if (shared_)
+    {
+        std::unique_ptr<description> result(new description);
+        result->shared_ = shared_;
+        return result;
+    }
+
     builder b;
     for (auto& child : *this)
         b.add_child(detail::unchecked_downcast<phrasing_entity>(child.clone()));
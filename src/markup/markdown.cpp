@@ -4,10 +4,14 @@
 
 #include <standardese/markup/generator.hpp>
 
+#include <algorithm>
 #include <cassert>
-#include <cmark-gfm.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <ostream>
-#include <sstream>
+#include <string>
+#include <vector>
 
 #include <standardese/markup/block.hpp>
 #include <standardese/markup/code_block.hpp>
@@ -29,608 +33,1178 @@
 
 using namespace standardese::markup;
 
+// The CommonMark is written straight to the stream while visiting the markup entities.
+// It follows the spacing and escaping rules of the CommonMark renderer of cmark,
+// as called by `cmark_render_commonmark(doc, CMARK_OPT_NOBREAKS, 0)`,
+// so the output is the same as when rendering a cmark node tree.
+// This includes the entities cmark drops because they aren't allowed as a child of a node.
+
 namespace
 {
-struct options
+bool is_space(char c) noexcept
 {
-    std::string prefix, extension;
-    bool        use_html;
-};
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-void build_entity(cmark_node* parent, const options& opt, const entity& e);
+bool is_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9';
+}
 
-template <typename T>
-void handle_children(cmark_node* node, const options& opt, const T& container)
+bool is_alpha(char c) noexcept
 {
-    for (auto& child : container)
-        build_entity(node, opt, child);
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
-cmark_node* build_emph(const char* str)
+bool is_punct(char c) noexcept
 {
-    auto emph = cmark_node_new(CMARK_NODE_EMPH);
-    auto text = cmark_node_new(CMARK_NODE_TEXT);
-    cmark_node_set_literal(text, str);
-    cmark_node_append_child(emph, text);
-    return emph;
+    return (c >= 33 && c <= 47) || (c >= 58 && c <= 64) || (c >= 91 && c <= 96)
+           || (c >= 123 && c <= 126);
 }
 
-cmark_node* build_heading(unsigned level, const char* str)
+// returns the length of the UTF-8 sequence at the beginning of the string and stores its code
+// point, returns 0 if the sequence is invalid
+std::size_t decode_utf8(const char* str, std::size_t size, std::uint32_t& code_point) noexcept
 {
-    auto heading = cmark_node_new(CMARK_NODE_HEADING);
-    cmark_node_set_heading_level(heading, int(level));
+    auto lead = static_cast<unsigned char>(str[0]);
+    if (lead < 0x80)
+    {
+        code_point = lead;
+        return 1;
+    }
 
-    if (str)
+    std::size_t length;
+    if (lead < 0xC0)
+        return 0;
+    else if (lead < 0xE0)
     {
-        auto text = cmark_node_new(CMARK_NODE_TEXT);
-        cmark_node_set_literal(text, str);
-        cmark_node_append_child(heading, text);
+        length     = 2;
+        code_point = lead & 0x1Fu;
     }
+    else if (lead < 0xF0)
+    {
+        length     = 3;
+        code_point = lead & 0x0Fu;
+    }
+    else if (lead < 0xF8)
+    {
+        length     = 4;
+        code_point = lead & 0x07u;
+    }
+    else
+        return 0;
 
-    return heading;
+    if (length > size)
+        return 0;
+    for (auto i = 1u; i != length; ++i)
+    {
+        auto c = static_cast<unsigned char>(str[i]);
+        if ((c & 0xC0) != 0x80)
+            return 0;
+        code_point = (code_point << 6) | (c & 0x3Fu);
+    }
+
+    // reject overlong sequences, surrogates and code points out of range
+    if ((length == 2 && code_point < 0x80)
+        || (length == 3 && (code_point < 0x800 || (code_point >= 0xD800 && code_point < 0xE000)))
+        || (length == 4 && (code_point < 0x10000 || code_point >= 0x110000)))
+        return 0;
+    return length;
 }
 
-void build(cmark_node* parent, const options& opt, const code_block& cb);
+// whether the URL starts with a scheme followed by a colon
+bool has_scheme(const char* url) noexcept
+{
+    if (!is_alpha(*url))
+        return false;
+
+    auto length = 1;
+    for (++url; is_alpha(*url) || is_digit(*url) || *url == '.' || *url == '+' || *url == '-';
+         ++url)
+        ++length;
+    return length >= 2 && length <= 32 && *url == ':';
+}
 
-void build_list_item(cmark_node* list, const options& opt, const list_item_base& item);
+std::size_t longest_backtick_sequence(const char* code) noexcept
+{
+    std::size_t longest = 0, current = 0;
+    for (; *code; ++code)
+        if (*code == '`')
+            ++current;
+        else
+        {
+            longest = std::max(longest, current);
+            current = 0;
+        }
+    return std::max(longest, current);
+}
 
-void build_documentation(cmark_node* parent, const options& opt, const documentation_entity& doc)
+std::size_t shortest_unused_backtick_sequence(const char* code) noexcept
 {
-    if (opt.use_html)
+    // bit n is set if there is a sequence of length n
+    std::uint32_t used = 1, current = 0;
+    for (auto end = code + std::strlen(code); code <= end; ++code)
+        if (*code == '`')
+            ++current;
+        else
+        {
+            if (current > 0 && current < 32)
+                used |= 1u << current;
+            current = 0;
+        }
+
+    std::size_t result = 0;
+    while (result < 32 && (used & 1))
     {
-        auto html = cmark_node_new(CMARK_NODE_HTML_BLOCK);
+        used >>= 1;
+        ++result;
+    }
+    return result;
+}
 
-        std::ostringstream stream;
-        stream << "<span id=\"standardese-";
-        detail::write_html_text(stream, doc.id().as_output_str().c_str());
-        stream << "\"></span>\n";
+enum class escaping
+{
+    literal,
+    normal,
+    url,
+    title,
+};
 
-        cmark_node_set_literal(html, stream.str().c_str());
-        cmark_node_append_child(parent, html);
+enum class block_type
+{
+    document,
+    block_quote,
+    list,
+    item,
+    paragraph,
+    heading,
+    code_block,
+    html_block,
+    thematic_break,
+};
+
+class markdown_stream
+{
+public:
+    explicit markdown_stream(std::ostream& out) : out_(out) {}
+
+    markdown_stream(const markdown_stream&) = delete;
+    markdown_stream& operator=(const markdown_stream&) = delete;
+
+    // writes the remaining output,
+    // it always ends with a newline
+    void finish()
+    {
+        if (!written_ || last_ != '\n')
+            put('\n');
+        flush();
     }
 
-    if (doc.synopsis())
-        build(parent, opt, doc.synopsis().value());
+    //=== blocks ===//
+    // the root is either a document or, for phrasing entities, a paragraph
+    void begin_root(block_type type)
+    {
+        assert(blocks_.empty());
+        blocks_.push_back({type, false, 0u, 0u});
+    }
 
-    if (auto brief = doc.brief_section())
+    void end_root()
     {
-        auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-        handle_children(paragraph, opt, brief.value());
-        cmark_node_append_child(parent, paragraph);
+        end_block();
     }
 
-    // write inline sections
+    void begin_block_quote()
     {
-        for (auto& section : doc.doc_sections())
-            if (section.kind() != entity_kind::inline_section)
-                continue;
-            else
-            {
-                auto& sec = static_cast<const inline_section&>(section);
+        begin_block(block_type::block_quote);
+        literal("> ");
+        begin_content_ = true;
+        prefix_ += "> ";
+    }
 
-                auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-                cmark_node_append_child(parent, paragraph);
+    // an ordered list has a start > 0, a bullet list a start of 0
+    void begin_list(bool tight, unsigned start = 0u)
+    {
+        begin_block(block_type::list, tight, start);
+    }
 
-                // add section name
-                auto emph = build_emph((sec.name() + ":").c_str());
-                cmark_node_append_child(paragraph, emph);
-                auto sep = cmark_node_new(CMARK_NODE_TEXT);
-                cmark_node_set_literal(sep, " ");
-                cmark_node_append_child(paragraph, sep);
+    void begin_item()
+    {
+        assert(blocks_.back().type == block_type::list);
+        auto start = blocks_.back().number;
+        auto index = blocks_.back().children;
+        begin_block(block_type::item);
 
-                // build section content
-                handle_children(paragraph, opt, sec);
-            }
+        char marker[32] = "  - ";
+        if (start != 0u)
+        {
+            auto number = start + index;
+            std::snprintf(marker, sizeof(marker), "%u.%s", number, number < 10u ? "  " : " ");
+        }
+        blocks_.back().number = unsigned(std::strlen(marker));
+        literal(marker);
+        begin_content_ = true;
+        prefix_.append(blocks_.back().number, ' ');
     }
 
-    // write details section
-    if (auto details = doc.details_section())
-        handle_children(parent, opt, details.value());
+    void begin_paragraph()
+    {
+        begin_block(block_type::paragraph);
+    }
 
-    // write list sections
-    for (auto& section : doc.doc_sections())
-        if (section.kind() != entity_kind::list_section)
-            continue;
+    void begin_heading(unsigned level)
+    {
+        begin_block(block_type::heading);
+        literal(std::string(level, '#').append(" ").c_str());
+        begin_content_ = true;
+    }
+
+    void end_block()
+    {
+        list_ended_ = false;
+
+        auto type           = blocks_.back().type;
+        in_tight_list_item_ = in_tight_list_item(type, blocks_.size() - 1u);
+        switch (type)
+        {
+        case block_type::block_quote:
+            prefix_.resize(prefix_.size() - 2u);
+            blankline();
+            break;
+        case block_type::item:
+            prefix_.resize(prefix_.size() - blocks_.back().number);
+            cr();
+            break;
+        case block_type::paragraph:
+        case block_type::heading:
+            blankline();
+            break;
+
+        default:
+            break;
+        }
+
+        blocks_.pop_back();
+        list_ended_ = type == block_type::list;
+    }
+
+    void code_block(const char* info, const char* code)
+    {
+        begin_block(block_type::code_block);
+
+        if (!first_in_item_)
+            blankline();
+
+        auto info_len = std::strlen(info);
+        auto code_len = std::strlen(code);
+        if (info_len == 0u && code_len > 2u && !is_space(code[0])
+            && !(is_space(code[code_len - 1u]) && is_space(code[code_len - 2u])) && !first_in_item_)
+        {
+            // indented code block
+            literal("    ");
+            prefix_ += "    ";
+            out(code, escaping::literal);
+            prefix_.resize(prefix_.size() - 4u);
+        }
         else
         {
-            auto& list = static_cast<const list_section&>(section);
+            auto ticks = std::max(longest_backtick_sequence(code) + 1u, std::size_t(3u));
+            auto fence = std::string(ticks, std::strchr(info, '`') ? '~' : '`');
+            literal(fence.c_str());
+            literal(" ");
+            out(info, escaping::literal);
+            cr();
+            out(code, escaping::literal);
+            cr();
+            literal(fence.c_str());
+        }
+        blankline();
+    }
 
-            // heading
-            auto heading = build_heading(4, list.name().c_str());
-            cmark_node_append_child(parent, heading);
+    void html_block(const char* html)
+    {
+        begin_block(block_type::html_block);
+        blankline();
+        out(html, escaping::literal);
+        blankline();
+    }
 
-            // list
-            auto ul = cmark_node_new(CMARK_NODE_LIST);
-            cmark_node_set_list_type(ul, CMARK_BULLET_LIST);
-            cmark_node_set_list_tight(ul, 1);
-            cmark_node_append_child(parent, ul);
+    void thematic_break()
+    {
+        begin_block(block_type::thematic_break);
+        blankline();
+        literal("-----");
+        blankline();
+    }
 
-            for (auto& item : list)
-                build_list_item(ul, opt, item);
+    //=== inlines ===//
+    void text(const char* str)
+    {
+        out(str, escaping::normal);
+    }
+
+    void code_span(const char* code)
+    {
+        auto length = std::strlen(code);
+        auto ticks  = std::string(shortest_unused_backtick_sequence(code), '`');
+
+        literal(ticks.c_str());
+        if (length == 0u || code[0] == '`')
+            literal(" ");
+        out(code, escaping::literal);
+        if (length == 0u || code[length - 1u] == '`')
+            literal(" ");
+        literal(ticks.c_str());
+    }
+
+    void html_inline(const char* html)
+    {
+        out(html, escaping::literal);
+    }
+
+    void soft_break()
+    {
+        literal(" ");
+    }
+
+    void hard_break()
+    {
+        literal("  ");
+        cr();
+    }
+
+    void autolink(const char* url)
+    {
+        literal("<");
+        literal(std::strncmp(url, "mailto:", 7u) == 0 ? url + 7 : url);
+        literal(">");
+    }
+
+    void begin_link()
+    {
+        literal("[");
+    }
+
+    void end_link(const char* url, const char* title)
+    {
+        literal("](");
+        out(url, escaping::url);
+        if (*title)
+        {
+            literal(" \"");
+            out(title, escaping::title);
+            literal("\"");
         }
-}
+        literal(")");
+    }
 
-void append_module(cmark_node* heading, const std::string& module)
-{
-    auto text = cmark_node_new(CMARK_NODE_TEXT);
-    cmark_node_set_literal(text, (" [" + module + "]").c_str());
-    cmark_node_append_child(heading, text);
-}
+    void literal(const char* str)
+    {
+        out(str, escaping::literal);
+    }
 
-void build_doc_header(cmark_node* parent, const options& opt, const documentation_header& header,
-                      unsigned level)
-{
-    auto heading = build_heading(level, nullptr);
-    cmark_node_append_child(parent, heading);
+private:
+    struct block
+    {
+        block_type type;
+        bool       tight;    // for lists
+        unsigned   number;   // start for lists, width of the marker for items
+        unsigned   children; // number of child blocks
+    };
 
-    handle_children(heading, opt, header.heading());
+    void cr() noexcept
+    {
+        if (need_cr_ < 1)
+            need_cr_ = 1;
+    }
 
-    if (header.module())
-        append_module(heading, header.module().value());
-}
+    void blankline() noexcept
+    {
+        if (need_cr_ < 2)
+            need_cr_ = 2;
+    }
 
-void build_doc_header(cmark_node* parent, const options& opt, const documentation_entity& doc,
-                      unsigned level)
-{
-    if (doc.header())
-        build_doc_header(parent, opt, doc.header().value(), level);
-}
+    // whether a block at the given position of the stack is the child of an item in a tight list
+    // or the child of such a child,
+    // the position may be the end of the stack for the current block
+    bool in_tight_list_item(block_type type, std::size_t pos) const noexcept
+    {
+        if (pos == 0u)
+            return false;
+        else if (type == block_type::item)
+            return blocks_[pos - 1u].tight;
+        else
+            return blocks_[pos - 1u].type == block_type::item && blocks_[pos - 2u].tight;
+    }
 
-void build(cmark_node* parent, const options& opt, const file_documentation& doc)
-{
-    build_doc_header(parent, opt, doc, 1);
-    build_documentation(parent, opt, doc);
-    handle_children(parent, opt, doc);
-}
+    void begin_block(block_type type, bool tight = false, unsigned number = 0u)
+    {
+        if (list_ended_)
+        {
+            // separate a list from a following code block or list
+            list_ended_ = false;
+            if (type == block_type::list || type == block_type::code_block)
+            {
+                cr();
+                literal("<!-- end list -->");
+                blankline();
+            }
+        }
 
-unsigned get_documentation_heading_level(const documentation_entity& doc)
-{
-    for (auto cur = doc.parent(); cur; cur = cur.value().parent())
-        if (cur.value().kind() == entity_kind::entity_documentation
-            || cur.value().kind() == entity_kind::namespace_documentation)
-            // use h3 when entity has a parent entity
-            return 3;
-    // return h2 otherwise
-    return 2;
-}
+        auto& parent   = blocks_.back();
+        first_in_item_ = parent.type == block_type::item && parent.children == 0u;
+        // the tight state isn't updated on the first item to keep the separation from the
+        // previous block
+        if (type != block_type::item || parent.children != 0u)
+            in_tight_list_item_ = in_tight_list_item(type, blocks_.size());
+        ++parent.children;
+
+        if (type != block_type::code_block && type != block_type::html_block
+            && type != block_type::thematic_break)
+            blocks_.push_back({type, tight, number, 0u});
+    }
 
-void build(cmark_node* parent, const options& opt, const entity_documentation& doc)
-{
-    build_doc_header(parent, opt, doc, get_documentation_heading_level(doc));
-    build_documentation(parent, opt, doc);
-    handle_children(parent, opt, doc);
+    bool needs_escaping(std::uint32_t c, char next, escaping esc) const noexcept
+    {
+        if (c >= 0x80)
+            return false;
 
-    if (doc.header())
-        cmark_node_append_child(parent, cmark_node_new(CMARK_NODE_THEMATIC_BREAK));
-}
+        switch (esc)
+        {
+        case escaping::literal:
+            return false;
 
-void build(cmark_node* parent, const options& opt, const entity_index_item& item);
-void build(cmark_node* parent, const options& opt, const namespace_documentation& doc);
-void build(cmark_node* parent, const options& opt, const module_documentation& doc);
+        case escaping::normal:
+        {
+            auto follows_digit = written_ && is_digit(last_);
+            return std::strchr("*_[]#<>\\`~!", int(c)) != nullptr || (c == '&' && is_alpha(next))
+                   || (begin_content_ && (c == '-' || c == '+' || c == '=') && !follows_digit)
+                   || (begin_content_ && (c == '.' || c == ')') && follows_digit
+                       && (next == '\0' || is_space(next)));
+        }
 
-void build_index_child(cmark_node* parent, const options& opt, const block_entity& child)
-{
-    if (child.kind() == entity_kind::entity_index_item)
-        build(parent, opt, static_cast<const entity_index_item&>(child));
-    else if (child.kind() == entity_kind::namespace_documentation)
-        build(parent, opt, static_cast<const namespace_documentation&>(child));
-    else if (child.kind() == entity_kind::module_documentation)
-        build(parent, opt, static_cast<const module_documentation&>(child));
-    else
-        assert(false);
-}
+        case escaping::url:
+            return std::strchr("`<>\\()", int(c)) != nullptr || is_space(char(c));
+        case escaping::title:
+            return std::strchr("`<>\"\\", int(c)) != nullptr;
+        }
 
-template <class T>
-void build_module_ns(cmark_node* parent, const options& opt, const T& doc)
-{
-    auto item = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, item);
+        return false;
+    }
+
+    void out(const char* str, escaping esc)
+    {
+        auto length = std::strlen(str);
+
+        // write the pending newlines, reusing those at the end of the output
+        if (in_tight_list_item_ && need_cr_ > 1)
+            need_cr_ = 1;
+        auto existing = written_only_newlines_ ? need_cr_ : int(trailing_newlines_);
+        for (; need_cr_ > 0; --need_cr_)
+        {
+            if (existing > 0)
+                --existing;
+            else
+            {
+                put('\n');
+                if (need_cr_ > 1)
+                    append(prefix_.c_str(), prefix_.size());
+            }
+            begin_line_    = true;
+            begin_content_ = true;
+        }
 
-    build_doc_header(item, opt, doc, get_documentation_heading_level(doc));
-    build_documentation(item, opt, doc);
+        for (std::size_t i = 0; i < length;)
+        {
+            if (begin_line_)
+                append(prefix_.c_str(), prefix_.size());
 
-    auto list = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(list, CMARK_BULLET_LIST);
-    cmark_node_append_child(item, list);
+            std::uint32_t c;
+            auto          len = decode_utf8(str + i, length - i, c);
+            if (len == 0u)
+                // cmark doesn't write the rest of the string either
+                break;
 
-    for (auto& child : doc)
-        build_index_child(list, opt, child);
-}
+            if (esc == escaping::literal && c == '\n')
+            {
+                put('\n');
+                begin_line_    = true;
+                begin_content_ = true;
+            }
+            else
+            {
+                if (needs_escaping(c, str[i + len], esc))
+                {
+                    if (esc == escaping::url && is_space(char(c)))
+                    {
+                        char encoded[8];
+                        std::snprintf(encoded, sizeof(encoded), "%%%2X", unsigned(c));
+                        append(encoded, std::strlen(encoded));
+                    }
+                    else
+                    {
+                        assert(is_punct(char(c)));
+                        put('\\');
+                        put(char(c));
+                    }
+                }
+                else
+                    append(str + i, len);
+
+                begin_line_ = false;
+                // cmark checks the lowest byte of the code point
+                begin_content_ = begin_content_ && is_digit(char(c & 0xFF));
+            }
 
-void build(cmark_node* parent, const options& opt, const namespace_documentation& doc)
-{
-    build_module_ns(parent, opt, doc);
-}
+            i += len;
+        }
 
-void build(cmark_node* parent, const options& opt, const module_documentation& doc)
-{
-    build_module_ns(parent, opt, doc);
-}
+        if (buffer_.size() >= 4096u)
+            flush();
+    }
 
-void build_term_description(cmark_node* parent, const options& opt, const term& t,
-                            const description* desc);
+    void put(char c)
+    {
+        buffer_ += c;
+        track(c);
+    }
 
-void build(cmark_node* parent, const options& opt, const entity_index_item& item)
-{
-    auto node = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, node);
-    build_term_description(node, opt, item.entity(),
-                           item.brief() ? &item.brief().value() : nullptr);
-}
+    void append(const char* str, std::size_t size)
+    {
+        buffer_.append(str, size);
+        for (auto i = 0u; i != size; ++i)
+            track(str[i]);
+    }
 
-template <class Index>
-void build_index(cmark_node* parent, const options& opt, const Index& index)
-{
-    auto heading = build_heading(1, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, index.heading());
+    void track(char c) noexcept
+    {
+        if (c == '\n')
+            ++trailing_newlines_;
+        else
+        {
+            trailing_newlines_     = 0u;
+            written_only_newlines_ = false;
+        }
+        last_    = c;
+        written_ = true;
+    }
 
-    auto list = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(list, CMARK_BULLET_LIST);
-    cmark_node_append_child(parent, list);
+    void flush()
+    {
+        out_.write(buffer_.data(), std::streamsize(buffer_.size()));
+        buffer_.clear();
+    }
 
-    for (auto& child : index)
-        build_index_child(list, opt, child);
-}
+    std::ostream&      out_;
+    std::string        buffer_;
+    std::string        prefix_;
+    std::vector<block> blocks_;
+
+    // the state of the end of the output
+    std::size_t trailing_newlines_     = 0u;
+    char        last_                  = '\0';
+    bool        written_               = false;
+    bool        written_only_newlines_ = true;
+
+    int  need_cr_            = 0;
+    bool begin_line_         = true;
+    bool begin_content_      = true;
+    bool in_tight_list_item_ = false;
+    bool first_in_item_      = false;
+    bool list_ended_         = false;
+};
 
-void build(cmark_node* parent, const options& opt, const file_index& index)
+struct options
 {
-    build_index(parent, opt, index);
-}
+    std::string prefix, extension;
+    bool        use_html;
+};
 
-void build(cmark_node* parent, const options& opt, const entity_index& index)
+bool is_unresolved(const documentation_link& link) noexcept
 {
-    build_index(parent, opt, index);
+    return !link.internal_destination() && !link.external_destination();
 }
 
-void build(cmark_node* parent, const options& opt, const module_index& index)
+bool is_code_block_token(entity_kind kind) noexcept
 {
-    build_index(parent, opt, index);
+    switch (kind)
+    {
+    case entity_kind::code_block_keyword:
+    case entity_kind::code_block_identifier:
+    case entity_kind::code_block_string_literal:
+    case entity_kind::code_block_int_literal:
+    case entity_kind::code_block_float_literal:
+    case entity_kind::code_block_punctuation:
+    case entity_kind::code_block_preprocessor:
+        return true;
+
+    default:
+        return false;
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const heading& h)
+// calls `f` for every entity that is written as an inline node,
+// the content of an unresolved link is written as if there was no link,
+// while blocks and code block tokens are ignored
+// returns false if `f` returned false to stop
+template <typename Func>
+bool for_each_inline_node(const entity& e, Func& f)
 {
-    auto heading = build_heading(4, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, h);
+    if (e.kind() == entity_kind::documentation_link
+        && is_unresolved(static_cast<const documentation_link&>(e)))
+    {
+        for (auto& child : static_cast<const documentation_link&>(e))
+            if (!for_each_inline_node(child, f))
+                return false;
+        return true;
+    }
+    else if (!is_phrasing(e.kind()) || is_code_block_token(e.kind()))
+        return true;
+    else
+        return f(e);
 }
 
-void build(cmark_node* parent, const options& opt, const subheading& h)
+template <typename T, typename Func>
+bool for_each_inline(const T& container, Func f)
 {
-    auto heading = build_heading(5, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, h);
+    for (auto& child : container)
+        if (!for_each_inline_node(child, f))
+            return false;
+    return true;
 }
 
-void build(cmark_node* parent, const options& opt, const paragraph& par)
+// appends the text of an entity inside a code block or code span
+void append_code_text(std::string& result, const entity& e, bool in_block)
 {
-    auto node = cmark_node_new(CMARK_NODE_PARAGRAPH);
-    cmark_node_append_child(parent, node);
-    handle_children(node, opt, par);
+    switch (e.kind())
+    {
+#define STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(Kind)                                                 \
+    case entity_kind::code_block_##Kind:                                                           \
+        result += static_cast<const code_block::Kind&>(e).string();                                \
+        break;
+
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(keyword)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(identifier)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(string_literal)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(int_literal)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(float_literal)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(punctuation)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(preprocessor)
+
+#undef STANDARDESE_DETAIL_HANDLE_CODE_BLOCK
+
+    case entity_kind::text:
+        result += static_cast<const text&>(e).string();
+        break;
+
+    case entity_kind::soft_break:
+    case entity_kind::hard_break:
+        if (in_block)
+            result += '\n';
+        break;
+
+    case entity_kind::external_link:
+        if (in_block)
+            for (auto& child : static_cast<const external_link&>(e))
+                append_code_text(result, child, in_block);
+        break;
+    case entity_kind::documentation_link:
+    {
+        // a code span can't contain links, but the content of an unresolved one is kept
+        auto& link = static_cast<const documentation_link&>(e);
+        if (in_block || is_unresolved(link))
+            for (auto& child : link)
+                append_code_text(result, child, in_block);
+        break;
+    }
+
+    default:
+        // everything else can't be part of code
+        break;
+    }
 }
 
-void build_term_description(cmark_node* parent, const options& opt, const term& t,
-                            const description* desc)
+template <typename T>
+std::string get_code_text(const T& container, bool in_block)
 {
-    auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-    cmark_node_append_child(parent, paragraph);
+    std::string result;
+    for (auto& child : container)
+        append_code_text(result, child, in_block);
+    return result;
+}
 
-    handle_children(paragraph, opt, t);
+void write_inline(markdown_stream& s, const options& opt, const entity& e, bool only_in_emph,
+                  bool merge_text);
 
-    if (desc)
+// writes the inline children of a container,
+// if `merge_text` is true, adjacent texts are written together,
+// like cmark does after consolidating the text nodes
+template <typename T>
+void write_inlines(markdown_stream& s, const options& opt, const T& container, bool in_emph,
+                   bool merge_text = false)
+{
+    auto only_child = false;
+    if (in_emph)
     {
-        if (opt.use_html)
+        auto count = 0u;
+        for_each_inline(container, [&](const entity&) { return ++count < 2u; });
+        only_child = count == 1u;
+    }
+
+    std::string merged;
+    auto        has_merged = false;
+    for_each_inline(container, [&](const entity& child) {
+        if (merge_text && child.kind() == entity_kind::text)
         {
-            auto html = cmark_node_new(CMARK_NODE_HTML_INLINE);
-            cmark_node_set_literal(html, " &mdash; ");
-            cmark_node_append_child(paragraph, html);
+            merged += static_cast<const text&>(child).string();
+            has_merged = true;
         }
         else
         {
-            auto text = cmark_node_new(CMARK_NODE_TEXT);
-            cmark_node_set_literal(text, " - ");
-            cmark_node_append_child(paragraph, text);
+            if (has_merged)
+            {
+                s.text(merged.c_str());
+                merged.clear();
+                has_merged = false;
+            }
+            write_inline(s, opt, child, only_child, merge_text);
         }
-
-        handle_children(paragraph, opt, *desc);
-    }
+        return true;
+    });
+    if (has_merged)
+        s.text(merged.c_str());
 }
 
-void build_list_item(cmark_node* parent, const options& opt, const list_item_base& item)
+std::string get_url(const options& opt, const documentation_link& link)
 {
-    auto li = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, li);
-
-    if (item.kind() == entity_kind::list_item)
-        handle_children(li, opt, static_cast<const list_item&>(item));
-    else if (item.kind() == entity_kind::term_description_item)
+    if (link.internal_destination())
     {
-        auto& term        = static_cast<const term_description_item&>(item).term();
-        auto& description = static_cast<const term_description_item&>(item).description();
-        build_term_description(li, opt, term, &description);
+        auto url = opt.prefix
+                   + link.internal_destination()
+                         .value()
+                         .document()
+                         .map(&output_name::file_name, opt.extension.c_str())
+                         .value_or("");
+        url += "#standardese-" + link.internal_destination().value().id().as_output_str();
+        return url;
     }
     else
-        assert(false);
+        return link.external_destination().value().as_str();
 }
 
-void build(cmark_node* parent, const options& opt, const unordered_list& list)
+// the string of the first child of a link cmark compares the URL with to detect autolinks,
+// it is empty for nodes without a string
+std::string get_autolink_text(const options& opt, const entity& first,
+                              const std::string& first_text)
 {
-    auto ul = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(ul, CMARK_BULLET_LIST);
-    cmark_node_append_child(parent, ul);
-
-    for (auto& item : list)
-        build_list_item(ul, opt, item);
-}
-
-void build(cmark_node* parent, const options& opt, const ordered_list& list)
-{
-    auto ul = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(ul, CMARK_ORDERED_LIST);
-    cmark_node_set_list_start(ul, 1);
-    cmark_node_append_child(parent, ul);
-
-    for (auto& item : list)
-        build_list_item(ul, opt, item);
+    switch (first.kind())
+    {
+    case entity_kind::text:
+        return first_text;
+    case entity_kind::code:
+        return get_code_text(static_cast<const code&>(first), false);
+    case entity_kind::verbatim:
+        return static_cast<const verbatim&>(first).content();
+    case entity_kind::external_link:
+        return static_cast<const external_link&>(first).url().as_str();
+    case entity_kind::documentation_link:
+        return get_url(opt, static_cast<const documentation_link&>(first));
+
+    default:
+        return "";
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const block_quote& quote)
+template <typename T>
+void write_link(markdown_stream& s, const options& opt, const T& link, const std::string& url,
+                bool merge_text)
 {
-    auto node = cmark_node_new(CMARK_NODE_BLOCK_QUOTE);
-    cmark_node_append_child(parent, node);
+    // cmark writes a link to its own URL as autolink,
+    // while checking that the adjacent texts at the start of the link are merged
+    const entity* first = nullptr;
+    std::string   first_text;
+    for_each_inline(link, [&](const entity& child) {
+        if (!first)
+            first = &child;
+        else if (first->kind() != entity_kind::text || child.kind() != entity_kind::text)
+            return false;
+
+        if (child.kind() == entity_kind::text)
+            first_text += static_cast<const text&>(child).string();
+        return true;
+    });
+
+    auto is_candidate = !url.empty() && has_scheme(url.c_str()) && link.title().empty() && first;
+    if (is_candidate
+        && get_autolink_text(opt, *first, first_text)
+               == (url.compare(0, 7, "mailto:") == 0 ? url.substr(7) : url))
+    {
+        s.autolink(url.c_str());
+        return;
+    }
 
-    handle_children(node, opt, quote);
+    s.begin_link();
+    if (merge_text || !is_candidate)
+        write_inlines(s, opt, link, false, merge_text);
+    else
+    {
+        // only the texts at the start or the content of the first child were merged
+        auto at_start = true;
+        for_each_inline(link, [&](const entity& child) {
+            if (at_start && first->kind() == entity_kind::text
+                && child.kind() == entity_kind::text)
+            {
+                if (&child == first)
+                    s.text(first_text.c_str());
+            }
+            else
+            {
+                write_inline(s, opt, child, false, &child == first);
+                at_start = false;
+            }
+            return true;
+        });
+    }
+    s.end_link(url.c_str(), link.title().c_str());
 }
 
-void build(cmark_node* parent, const options& opt, const code_block& cb)
+void write_inline(markdown_stream& s, const options& opt, const entity& e, bool only_in_emph,
+                  bool merge_text)
 {
-    if (opt.use_html)
+    switch (e.kind())
     {
-        auto node = cmark_node_new(CMARK_NODE_HTML_BLOCK);
-        cmark_node_append_child(parent, node);
+    case entity_kind::text:
+        s.text(static_cast<const text&>(e).string().c_str());
+        break;
 
-        auto html = render(html_generator(opt.prefix, opt.extension), cb);
-        cmark_node_set_literal(node, html.c_str());
-    }
-    else
+    case entity_kind::emphasis:
     {
-        auto node = cmark_node_new(CMARK_NODE_CODE_BLOCK);
-        cmark_node_append_child(parent, node);
+        // `**` would be strong emphasis
+        auto delimiter = only_in_emph ? "_" : "*";
+        s.literal(delimiter);
+        write_inlines(s, opt, static_cast<const emphasis&>(e), true, merge_text);
+        s.literal(delimiter);
+        break;
+    }
+    case entity_kind::strong_emphasis:
+        s.literal("**");
+        write_inlines(s, opt, static_cast<const strong_emphasis&>(e), false, merge_text);
+        s.literal("**");
+        break;
 
-        if (!cb.language().empty())
-            cmark_node_set_fence_info(node, cb.language().c_str());
+    case entity_kind::code:
+        s.code_span(get_code_text(static_cast<const code&>(e), false).c_str());
+        break;
+    case entity_kind::verbatim:
+        // write inline HTML and hope it works
+        s.html_inline(static_cast<const verbatim&>(e).content().c_str());
+        break;
 
-        handle_children(node, opt, cb);
-    }
-}
+    case entity_kind::soft_break:
+        s.soft_break();
+        break;
+    case entity_kind::hard_break:
+        s.hard_break();
+        break;
 
-void append_code_block_text(cmark_node* cb, const std::string& text)
-{
-    auto str = cmark_node_get_literal(cb);
-    if (str)
-        cmark_node_set_literal(cb, (str + text).c_str());
-    else
-        cmark_node_set_literal(cb, text.c_str());
-}
+    case entity_kind::external_link:
+    {
+        auto& link = static_cast<const external_link&>(e);
+        write_link(s, opt, link, link.url().as_str(), merge_text);
+        break;
+    }
+    case entity_kind::documentation_link:
+    {
+        auto& link = static_cast<const documentation_link&>(e);
+        write_link(s, opt, link, get_url(opt, link), merge_text);
+        break;
+    }
 
-void build(cmark_node* parent, const options&, const code_block::keyword& text)
-{
-    append_code_block_text(parent, text.string());
+    default:
+        assert(false);
+        break;
+    }
 }
 
-void build(cmark_node* parent, const options&, const code_block::identifier& text)
-{
-    append_code_block_text(parent, text.string());
-}
+void write_block(markdown_stream& s, const options& opt, const entity& e);
 
-void build(cmark_node* parent, const options&, const code_block::string_literal& text)
+template <typename T>
+void write_blocks(markdown_stream& s, const options& opt, const T& container)
 {
-    append_code_block_text(parent, text.string());
+    for (auto& child : container)
+        write_block(s, opt, child);
 }
 
-void build(cmark_node* parent, const options&, const code_block::int_literal& text)
+void write_code_block(markdown_stream& s, const options& opt, const code_block& cb)
 {
-    append_code_block_text(parent, text.string());
+    if (opt.use_html)
+        s.html_block(render(html_generator(opt.prefix, opt.extension), cb).c_str());
+    else
+        s.code_block(cb.language().c_str(), get_code_text(cb, true).c_str());
 }
 
-void build(cmark_node* parent, const options&, const code_block::float_literal& text)
+void write_term_description(markdown_stream& s, const options& opt, const term& t,
+                            const description* desc)
 {
-    append_code_block_text(parent, text.string());
+    s.begin_paragraph();
+    write_inlines(s, opt, t, false);
+    if (desc)
+    {
+        if (opt.use_html)
+            s.html_inline(" &mdash; ");
+        else
+            s.text(" - ");
+        write_inlines(s, opt, *desc, false);
+    }
+    s.end_block();
 }
 
-void build(cmark_node* parent, const options&, const code_block::punctuation& text)
+void write_list_item(markdown_stream& s, const options& opt, const list_item_base& item)
 {
-    append_code_block_text(parent, text.string());
+    s.begin_item();
+    if (item.kind() == entity_kind::list_item)
+        write_blocks(s, opt, static_cast<const list_item&>(item));
+    else if (item.kind() == entity_kind::term_description_item)
+    {
+        auto& term        = static_cast<const term_description_item&>(item).term();
+        auto& description = static_cast<const term_description_item&>(item).description();
+        write_term_description(s, opt, term, &description);
+    }
+    else
+        assert(false);
+    s.end_block();
 }
 
-void build(cmark_node* parent, const options&, const code_block::preprocessor& text)
+void write_documentation(markdown_stream& s, const options& opt, const documentation_entity& doc)
 {
-    append_code_block_text(parent, text.string());
-}
+    if (opt.use_html)
+    {
+        std::string html = "<span id=\"standardese-";
+        detail::write_html_text(html, doc.id().as_output_str().c_str());
+        html += "\"></span>\n";
+        s.html_block(html.c_str());
+    }
 
-void build(cmark_node* parent, const options&, const thematic_break&)
-{
-    auto node = cmark_node_new(CMARK_NODE_THEMATIC_BREAK);
-    cmark_node_append_child(parent, node);
-}
+    if (doc.synopsis())
+        write_code_block(s, opt, doc.synopsis().value());
 
-void build(cmark_node* parent, const options&, const text& t)
-{
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK
-        || cmark_node_get_type(parent) == CMARK_NODE_CODE)
-        append_code_block_text(parent, t.string());
-    else
+    if (auto brief = doc.brief_section())
     {
-        auto text = cmark_node_new(CMARK_NODE_TEXT);
-        cmark_node_append_child(parent, text);
-        cmark_node_set_literal(text, t.string().c_str());
+        s.begin_paragraph();
+        write_inlines(s, opt, brief.value(), false);
+        s.end_block();
     }
-}
 
-void build(cmark_node* parent, const options& opt, const emphasis& emph)
-{
-    auto node = cmark_node_new(CMARK_NODE_EMPH);
-    cmark_node_append_child(parent, node);
+    // write inline sections
+    for (auto& section : doc.doc_sections())
+        if (section.kind() == entity_kind::inline_section)
+        {
+            auto& sec = static_cast<const inline_section&>(section);
+
+            s.begin_paragraph();
+            s.literal("*");
+            s.text((sec.name() + ":").c_str());
+            s.literal("*");
+            s.text(" ");
+            write_inlines(s, opt, sec, false);
+            s.end_block();
+        }
 
-    handle_children(node, opt, emph);
-}
+    // write details section
+    if (auto details = doc.details_section())
+        write_blocks(s, opt, details.value());
 
-void build(cmark_node* parent, const options& opt, const strong_emphasis& emph)
-{
-    auto node = cmark_node_new(CMARK_NODE_STRONG);
-    cmark_node_append_child(parent, node);
+    // write list sections
+    for (auto& section : doc.doc_sections())
+        if (section.kind() == entity_kind::list_section)
+        {
+            auto& list = static_cast<const list_section&>(section);
+
+            s.begin_heading(4);
+            s.text(list.name().c_str());
+            s.end_block();
 
-    handle_children(node, opt, emph);
+            s.begin_list(true);
+            for (auto& item : list)
+                write_list_item(s, opt, item);
+            s.end_block();
+        }
 }
 
-void build(cmark_node* parent, const options& opt, const code& c)
+void write_doc_header(markdown_stream& s, const options& opt, const documentation_entity& doc,
+                      unsigned level)
 {
-    auto node = cmark_node_new(CMARK_NODE_CODE);
-    cmark_node_append_child(parent, node);
-    handle_children(node, opt, c);
+    if (!doc.header())
+        return;
+
+    auto& header = doc.header().value();
+    s.begin_heading(level);
+    write_inlines(s, opt, header.heading(), false);
+    if (header.module())
+        s.text((" [" + header.module().value() + "]").c_str());
+    s.end_block();
 }
 
-void build(cmark_node* parent, const options&, const verbatim& v)
+unsigned get_documentation_heading_level(const documentation_entity& doc)
 {
-    // build inline HTML and hope it works
-    auto node = cmark_node_new(CMARK_NODE_HTML_INLINE);
-    cmark_node_append_child(parent, node);
-    cmark_node_set_literal(node, v.content().c_str());
+    for (auto cur = doc.parent(); cur; cur = cur.value().parent())
+        if (cur.value().kind() == entity_kind::entity_documentation
+            || cur.value().kind() == entity_kind::namespace_documentation)
+            // use h3 when entity has a parent entity
+            return 3;
+    // return h2 otherwise
+    return 2;
 }
 
-void build(cmark_node* parent, const options&, const soft_break&)
+void write_index_child(markdown_stream& s, const options& opt, const block_entity& child);
+
+template <class T>
+void write_module_ns(markdown_stream& s, const options& opt, const T& doc)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        append_code_block_text(parent, "\n");
-    else
-    {
-        auto node = cmark_node_new(CMARK_NODE_SOFTBREAK);
-        cmark_node_append_child(parent, node);
-    }
+    s.begin_item();
+    write_doc_header(s, opt, doc, get_documentation_heading_level(doc));
+    write_documentation(s, opt, doc);
+
+    s.begin_list(false);
+    for (auto& child : doc)
+        write_index_child(s, opt, child);
+    s.end_block();
+
+    s.end_block();
 }
 
-void build(cmark_node* parent, const options&, const hard_break&)
+void write_index_child(markdown_stream& s, const options& opt, const block_entity& child)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        append_code_block_text(parent, "\n");
-    else
+    if (child.kind() == entity_kind::entity_index_item)
     {
-        auto node = cmark_node_new(CMARK_NODE_LINEBREAK);
-        cmark_node_append_child(parent, node);
+        auto& item = static_cast<const entity_index_item&>(child);
+        s.begin_item();
+        write_term_description(s, opt, item.entity(),
+                               item.brief() ? &item.brief().value() : nullptr);
+        s.end_block();
     }
+    else if (child.kind() == entity_kind::namespace_documentation)
+        write_module_ns(s, opt, static_cast<const namespace_documentation&>(child));
+    else if (child.kind() == entity_kind::module_documentation)
+        write_module_ns(s, opt, static_cast<const module_documentation&>(child));
+    else
+        assert(false);
 }
 
-cmark_node* build_link(const char* title, const char* url)
+template <class Index>
+void write_index(markdown_stream& s, const options& opt, const Index& index)
 {
-    auto node = cmark_node_new(CMARK_NODE_LINK);
-    if (*title != '\0')
-        cmark_node_set_title(node, title);
-    cmark_node_set_url(node, url);
+    s.begin_heading(1);
+    write_inlines(s, opt, index.heading(), false);
+    s.end_block();
 
-    return node;
+    s.begin_list(false);
+    for (auto& child : index)
+        write_index_child(s, opt, child);
+    s.end_block();
 }
 
-void build(cmark_node* parent, const options& opt, const external_link& link)
+template <class List>
+void write_list(markdown_stream& s, const List& list, const options& opt, unsigned start)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        handle_children(parent, opt, link);
-    else
-    {
-        auto node = build_link(link.title().c_str(), link.url().as_str().c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
-    }
+    s.begin_list(false, start);
+    for (auto& item : list)
+        write_list_item(s, opt, item);
+    s.end_block();
 }
 
-void build(cmark_node* parent, const options& opt, const documentation_link& link)
+// writes a block that is the child of a document, list item or block quote
+void write_block(markdown_stream& s, const options& opt, const entity& e)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        handle_children(parent, opt, link);
-    else if (link.internal_destination())
+    switch (e.kind())
     {
-        auto url = opt.prefix
-                   + link.internal_destination()
-                         .value()
-                         .document()
-                         .map(&output_name::file_name, opt.extension.c_str())
-                         .value_or("");
-        url += "#standardese-" + link.internal_destination().value().id().as_output_str();
-
-        auto node = build_link(link.title().c_str(), url.c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
-    }
-    else if (link.external_destination())
+    case entity_kind::file_documentation:
     {
-        auto url = link.external_destination().value().as_str();
-
-        auto node = build_link(link.title().c_str(), url.c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
+        auto& doc = static_cast<const file_documentation&>(e);
+        write_doc_header(s, opt, doc, 1);
+        write_documentation(s, opt, doc);
+        write_blocks(s, opt, doc);
+        break;
     }
-    else
-        // only write link content
-        handle_children(parent, opt, link);
-}
-
-void build_entity(cmark_node* parent, const options& opt, const entity& e)
-{
-    switch (e.kind())
+    case entity_kind::entity_documentation:
     {
-#define STANDARDESE_DETAIL_HANDLE(Kind)                                                            \
-    case entity_kind::Kind:                                                                        \
-        build(parent, opt, static_cast<const Kind&>(e));                                           \
+        auto& doc = static_cast<const entity_documentation&>(e);
+        write_doc_header(s, opt, doc, get_documentation_heading_level(doc));
+        write_documentation(s, opt, doc);
+        write_blocks(s, opt, doc);
+        if (doc.header())
+            s.thematic_break();
         break;
-#define STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(Kind)                                                 \
-    case entity_kind::code_block_##Kind:                                                           \
-        build(parent, opt, static_cast<const code_block::Kind&>(e));                               \
+    }
+    case entity_kind::module_documentation:
+        // it is written as a list item, which is only allowed in an index
         break;
 
-        STANDARDESE_DETAIL_HANDLE(file_documentation)
-        STANDARDESE_DETAIL_HANDLE(entity_documentation)
-        STANDARDESE_DETAIL_HANDLE(module_documentation)
-
-        STANDARDESE_DETAIL_HANDLE(file_index)
-        STANDARDESE_DETAIL_HANDLE(entity_index)
-        STANDARDESE_DETAIL_HANDLE(module_index)
-
-        STANDARDESE_DETAIL_HANDLE(heading)
-        STANDARDESE_DETAIL_HANDLE(subheading)
-
-        STANDARDESE_DETAIL_HANDLE(paragraph)
+    case entity_kind::file_index:
+        write_index(s, opt, static_cast<const file_index&>(e));
+        break;
+    case entity_kind::entity_index:
+        write_index(s, opt, static_cast<const entity_index&>(e));
+        break;
+    case entity_kind::module_index:
+        write_index(s, opt, static_cast<const module_index&>(e));
+        break;
 
-        STANDARDESE_DETAIL_HANDLE(unordered_list)
-        STANDARDESE_DETAIL_HANDLE(ordered_list)
+    case entity_kind::heading:
+        s.begin_heading(4);
+        write_inlines(s, opt, static_cast<const heading&>(e), false);
+        s.end_block();
+        break;
+    case entity_kind::subheading:
+        s.begin_heading(5);
+        write_inlines(s, opt, static_cast<const subheading&>(e), false);
+        s.end_block();
+        break;
 
-        STANDARDESE_DETAIL_HANDLE(block_quote)
+    case entity_kind::paragraph:
+        s.begin_paragraph();
+        write_inlines(s, opt, static_cast<const paragraph&>(e), false);
+        s.end_block();
+        break;
 
-        STANDARDESE_DETAIL_HANDLE(code_block)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(keyword)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(identifier)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(string_literal)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(int_literal)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(float_literal)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(punctuation)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(preprocessor)
+    case entity_kind::unordered_list:
+        write_list(s, static_cast<const unordered_list&>(e), opt, 0u);
+        break;
+    case entity_kind::ordered_list:
+        write_list(s, static_cast<const ordered_list&>(e), opt, 1u);
+        break;
 
-        STANDARDESE_DETAIL_HANDLE(thematic_break)
+    case entity_kind::block_quote:
+        s.begin_block_quote();
+        write_blocks(s, opt, static_cast<const block_quote&>(e));
+        s.end_block();
+        break;
 
-        STANDARDESE_DETAIL_HANDLE(text)
-        STANDARDESE_DETAIL_HANDLE(emphasis)
-        STANDARDESE_DETAIL_HANDLE(strong_emphasis)
-        STANDARDESE_DETAIL_HANDLE(code)
-        STANDARDESE_DETAIL_HANDLE(verbatim)
-        STANDARDESE_DETAIL_HANDLE(soft_break)
-        STANDARDESE_DETAIL_HANDLE(hard_break)
+    case entity_kind::code_block:
+        write_code_block(s, opt, static_cast<const code_block&>(e));
+        break;
 
-        STANDARDESE_DETAIL_HANDLE(external_link)
-        STANDARDESE_DETAIL_HANDLE(documentation_link)
+    case entity_kind::thematic_break:
+        s.thematic_break();
+        break;
 
-#undef STANDARDESE_DETAIL_HANDLE
-#undef STANDARDESE_DETAIL_HANDLE_CODE_BLOCK
+    case entity_kind::code_block_keyword:
+    case entity_kind::code_block_identifier:
+    case entity_kind::code_block_string_literal:
+    case entity_kind::code_block_int_literal:
+    case entity_kind::code_block_float_literal:
+    case entity_kind::code_block_punctuation:
+    case entity_kind::code_block_preprocessor:
+    case entity_kind::text:
+    case entity_kind::emphasis:
+    case entity_kind::strong_emphasis:
+    case entity_kind::code:
+    case entity_kind::verbatim:
+    case entity_kind::soft_break:
+    case entity_kind::hard_break:
+    case entity_kind::external_link:
+    case entity_kind::documentation_link:
+        // not allowed outside of a paragraph
+        break;
 
     case entity_kind::main_document:
     case entity_kind::subdocument:
@@ -650,18 +1224,27 @@ void build_entity(cmark_node* parent, const options& opt, const entity& e)
     }
 }
 
-cmark_node* build_entity(const options& opt, const entity& e)
+void write_entity(markdown_stream& s, const options& opt, const entity& e)
 {
-    auto doc = is_phrasing(e.kind()) ? cmark_node_new(CMARK_NODE_PARAGRAPH)
-                                     : cmark_node_new(CMARK_NODE_DOCUMENT);
-
-    if (e.kind() == entity_kind::main_document || e.kind() == entity_kind::subdocument
-        || e.kind() == entity_kind::template_document)
-        handle_children(doc, opt, static_cast<const document_entity&>(e));
+    if (is_phrasing(e.kind()))
+    {
+        s.begin_root(block_type::paragraph);
+        auto write = [&](const entity& child) {
+            write_inline(s, opt, child, false, false);
+            return true;
+        };
+        for_each_inline_node(e, write);
+    }
     else
-        build_entity(doc, opt, e);
-
-    return doc;
+    {
+        s.begin_root(block_type::document);
+        if (e.kind() == entity_kind::main_document || e.kind() == entity_kind::subdocument
+            || e.kind() == entity_kind::template_document)
+            write_blocks(s, opt, static_cast<const document_entity&>(e));
+        else
+            write_block(s, opt, e);
+    }
+    s.end_root();
 }
 } // namespace
 
@@ -670,26 +1253,8 @@ generator standardese::markup::markdown_generator(bool use_html, const std::stri
 {
     options opt{prefix, extension, use_html};
     return [opt](std::ostream& out, const entity& e) {
-        auto doc = build_entity(opt, e);
-
-        auto str = cmark_render_commonmark(doc, CMARK_OPT_NOBREAKS, 0);
-        out << str;
-        std::free(str);
-
-        cmark_node_free(doc);
-    };
-}
-
-generator standardese::markup::text_generator() noexcept
-{
-    options opt{"", "txt", false};
-    return [opt](std::ostream& out, const entity& e) {
-        auto doc = build_entity(opt, e);
-
-        auto str = cmark_render_plaintext(doc, CMARK_OPT_NOBREAKS, 0);
-        out << str;
-        std::free(str);
-
-        cmark_node_free(doc);
+        markdown_stream stream(out);
+        write_entity(stream, opt, e);
+        stream.finish();
     };
 }
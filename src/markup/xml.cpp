@@ -25,6 +25,8 @@
 #include <standardese/markup/quote.hpp>
 #include <standardese/markup/thematic_break.hpp>
 
+#include "escape.hpp"
+
 using namespace standardese::markup;
 
 namespace
@@ -82,22 +84,7 @@ public:
     // writes XML escaped text
     void write(const char* str)
     {
-        for (auto ptr = str; *ptr; ++ptr)
-        {
-            auto c = *ptr;
-            if (c == '&')
-                *out_ << "&amp;";
-            else if (c == '<')
-                *out_ << "&lt;";
-            else if (c == '>')
-                *out_ << "&gt;";
-            else if (c == '"')
-                *out_ << "&quot;";
-            else if (c == '\'')
-                *out_ << "&apos;";
-            else
-                *out_ << c;
-        }
+        detail::write_xml_text(*out_, str);
     }
 
     void write(const std::string& str)
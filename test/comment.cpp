@@ -3,11 +3,13 @@
 // found in the top-level directory of this distribution.
 
 #include <standardese/comment.hpp>
+#include <standardese/doc_entity.hpp>
 
 #include <fstream>
 
 #include <cppast/cpp_class.hpp>
 #include <cppast/cpp_function.hpp>
+#include <cppast/cpp_namespace.hpp>
 #include <cppast/cpp_template.hpp>
 #include <cppast/visitor.hpp>
 
@@ -186,6 +188,108 @@ TEST_CASE("comment")
             return true;
         });
     }
+    SECTION("remote across files")
+    {
+        auto file_a = parse_file({}, "comment_remote_a.cpp", R"(
+            struct a {};
+
+            /// \group g
+            void b();
+            )");
+        auto file_b = parse_file({}, "comment_remote_b.cpp", R"(
+            /// \entity a
+            /// \module a
+
+            /// \group g
+            void c();
+            )");
+
+        file_comment_parser parser(test_logger());
+        parser.parse(type_safe::ref(*file_b));
+        parser.parse(type_safe::ref(*file_a));
+        auto registry = parser.finish();
+
+        auto comment = registry.get_comment(*file_a->begin());
+        REQUIRE(comment);
+        REQUIRE(comment.value().metadata().module() == "a");
+
+        auto group = registry.lookup_group("g");
+        REQUIRE(static_cast<std::size_t>(group.size()) == 2u);
+        REQUIRE(group[0]->name() == "b");
+        REQUIRE(group[1]->name() == "c");
+    }
+    SECTION("blacklisted")
+    {
+        auto file = parse_file({}, "comment_blacklisted.cpp", R"(
+            namespace detail
+            {
+                /// Some documentation.
+                /// \module a
+                ///
+                /// \returns Something.
+                int a();
+
+                /// \param c
+                /// \exclude
+                ///
+                /// Some documentation.
+                /// \unique_name detail_a2
+                int a2(int c);
+
+                struct base
+                {
+                    /// Some documentation.
+                    /// \param d Some more.
+                    void d_(int d);
+                };
+            }
+
+            struct b
+            {
+            private:
+                /// \param c
+                /// Some documentation.
+                void b_(int c);
+            };
+            )");
+
+        entity_blacklist blacklist;
+        blacklist.blacklist_namespace("detail");
+
+        file_comment_parser parser(test_logger(), comment::config(), type_safe::ref(blacklist));
+        parser.parse(type_safe::ref(*file));
+        auto registry = parser.finish();
+
+        // only the commands are parsed
+        auto& a       = *static_cast<const cppast::cpp_namespace&>(*file->begin()).begin();
+        auto  comment = registry.get_comment(a);
+        REQUIRE(comment);
+        REQUIRE(comment.value().metadata().module() == "a");
+        REQUIRE(!comment.value().brief_section());
+        REQUIRE(comment.value().sections().empty());
+
+        // the commands of an inline belong to the inline
+        auto& detail     = static_cast<const cppast::cpp_namespace&>(*file->begin());
+        auto  a2_comment = registry.get_comment(*std::next(detail.begin()));
+        REQUIRE(a2_comment);
+        REQUIRE(a2_comment.value().metadata().unique_name() == "detail_a2");
+        REQUIRE(!a2_comment.value().metadata().exclude());
+
+        // the members of a class might be injected into a derived class, so they're parsed
+        auto& base      = static_cast<const cppast::cpp_class&>(*std::next(detail.begin(), 2));
+        auto  d_comment = registry.get_comment(*base.begin());
+        REQUIRE(d_comment);
+        REQUIRE(d_comment.value().brief_section());
+        REQUIRE(registry.get_comment(
+            *static_cast<const cppast::cpp_function_base&>(*base.begin()).parameters().begin()));
+
+        // the first child is the access specifier
+        auto& b  = *std::next(file->begin());
+        auto& b_ = *std::next(static_cast<const cppast::cpp_class&>(b).begin());
+        REQUIRE(!registry.get_comment(b_));
+        REQUIRE(!registry.get_comment(
+            *static_cast<const cppast::cpp_function_base&>(b_).parameters().begin()));
+    }
     SECTION("member groups")
     {
         auto file = parse_file({}, "comment_member_groups.cpp", R"(
@@ -288,4 +392,45 @@ TEST_CASE("comment")
     }
 }
 
+TEST_CASE("unique names")
+{
+    auto file = parse_file({}, "unique_names.hpp", R"(
+        namespace ns
+        {
+            struct a
+            {
+                void f(int);
+            };
+        }
+        )");
+    auto& ns = static_cast<const cppast::cpp_namespace&>(*file->begin());
+    auto& a  = *ns.begin();
+    auto& f  = *static_cast<const cppast::cpp_class&>(a).begin();
+
+    comment_registry registry;
+    REQUIRE(lookup_unique_name(registry, f) == "ns::a::f(int)");
+    REQUIRE(lookup_unique_name(registry, a) == "ns::a");
+
+    // registering a unique name must not use the cached names anymore
+    comment::metadata metadata;
+    metadata.set_unique_name("b");
+    registry.register_comment(type_safe::ref(a), comment::doc_comment(metadata, nullptr, {}));
+    REQUIRE(lookup_unique_name(registry, a) == "b");
+    REQUIRE(lookup_unique_name(registry, f) == "b::f(int)");
+
+    SECTION("moved-from registry")
+    {
+        auto moved = std::move(registry);
+        REQUIRE(lookup_unique_name(moved, f) == "b::f(int)");
+
+        // the moved-from registry can still be used
+        registry.register_comment(type_safe::ref(a), comment::doc_comment(metadata, nullptr, {}));
+        registry.merge(comment_registry());
+        REQUIRE(lookup_unique_name(registry, f) == "b::f(int)");
+
+        registry = std::move(moved);
+        REQUIRE(lookup_unique_name(registry, f) == "b::f(int)");
+    }
+}
+
 }
@@ -1110,4 +1110,81 @@ TEST_CASE("Standardese Commands", "[comment]")
     }
 }
 
+TEST_CASE("Command Candidates", "[comment]")
+{
+    using standardese::comment::any_command;
+    using standardese::comment::inline_type;
+    using standardese::comment::section_type;
+
+    const auto candidates = [](const standardese::comment::config& config, const std::string& text) {
+        std::vector<any_command> result;
+        config.get_command_candidates(text.data(), text.data() + text.size(), result);
+        return result;
+    };
+
+    SECTION("Default Commands are Found by their Name")
+    {
+        const standardese::comment::config config;
+
+        CHECK(candidates(config, "\\returns a value") == std::vector<any_command>{section_type::returns});
+        CHECK(candidates(config, "\\param a") == std::vector<any_command>{inline_type::param});
+        CHECK(candidates(config, "\\returnsx").empty());
+        CHECK(candidates(config, "returns").empty());
+        CHECK(candidates(config, "").empty());
+    }
+    SECTION("Custom Commands are Always Candidates")
+    {
+        standardese::comment::config::options options;
+        options.command_patterns.push_back("returns=RETURNS:");
+        options.command_patterns.push_back("param|=:param ([^:]+):");
+        const standardese::comment::config config(options);
+
+        CHECK(candidates(config, "RETURNS: a value") == std::vector<any_command>{section_type::returns, inline_type::param});
+        CHECK(candidates(config, "\\brief") == std::vector<any_command>{section_type::brief, section_type::returns, inline_type::param});
+        CHECK(candidates(config, "\\tparam T") == std::vector<any_command>{section_type::returns, inline_type::param, inline_type::tparam});
+    }
+}
+
+TEST_CASE("Parsers can be Reused", "[comment]")
+{
+    const parser p;
+
+    SECTION("Sections are not Carried Over to the Next Comment")
+    {
+        const auto first = parse(p, unindent(R"(
+            \brief The first brief.
+            \returns The first return value.
+            )"), true);
+        const auto second = parse(p, unindent(R"(
+            The second brief.
+
+            \param a The brief of the parameter a.
+            )"), true);
+
+        CHECK_BRIEF_EQUIVALENT_TO(first, R"(
+            <brief-section>The first brief.</brief-section>
+            )");
+        CHECK_SECTIONS_EQUIVALENT_TO(first, R"(
+            <inline-section name="Return values">The first return value.</inline-section>
+            )");
+
+        CHECK_BRIEF_EQUIVALENT_TO(second, R"(
+            <brief-section>The second brief.</brief-section>
+            )");
+        CHECK_SECTIONS_EQUIVALENT_TO(second, std::vector<std::string>{});
+        CHECK_BRIEF_EQUIVALENT_TO(second.inlines.at(0), R"(
+            <brief-section>The brief of the parameter a.</brief-section>
+            )");
+    }
+    SECTION("A Parse Error does not Affect the Next Comment")
+    {
+        CHECK_THROWS_AS(parse(p, "![image](https://example.com/image.png)", true), parse_error);
+
+        const auto parsed = parse(p, "The brief.", true);
+        CHECK_BRIEF_EQUIVALENT_TO(parsed, R"(
+            <brief-section>The brief.</brief-section>
+            )");
+    }
+}
+
 }
@@ -4,6 +4,9 @@
 
 #include <standardese/doc_entity.hpp>
 
+#include <cppast/cpp_class.hpp>
+#include <cppast/cpp_namespace.hpp>
+
 #include "../external/catch/single_include/catch2/catch.hpp"
 
 #include "test_parser.hpp"
@@ -274,6 +277,51 @@ file - doc_entity__base_inline
     entity - base_base::a()
     entity - base::b()
     entity - foo::c()
+)");
+    }
+    SECTION("blacklisted base inline")
+    {
+        entity_blacklist blacklist;
+        blacklist.blacklist_namespace("detail");
+
+        auto file = parse_file({}, "doc_entity__blacklisted_base_inline", R"(
+namespace detail
+{
+    struct foo_base
+    {
+        /// Documented in foo.
+        void a();
+    };
+}
+
+/// Documentation.
+class foo : public detail::foo_base
+{
+public:
+    /// Documentation.
+    void b();
+};
+)");
+
+        // the comments in the blacklisted namespace are only scanned for commands,
+        // but the members of the base are documented in foo, so they must be parsed
+        file_comment_parser parser(test_logger(), comment::config(), type_safe::ref(blacklist));
+        parser.parse(type_safe::ref(*file));
+        comments.merge(parser.finish());
+
+        auto& detail  = static_cast<const cppast::cpp_namespace&>(*file->begin());
+        auto& a       = *static_cast<const cppast::cpp_class&>(*detail.begin()).begin();
+        auto  comment = comments.get_comment(a);
+        REQUIRE(comment);
+        REQUIRE(comment.value().brief_section());
+
+        // they aren't hidden as uncommented either
+        auto doc = build_doc_entities(comments, {}, std::move(file), blacklist, true);
+        REQUIRE(debug_string(*doc) == R"(
+file - doc_entity__blacklisted_base_inline
+  entity - foo
+    entity - detail::foo_base::a()
+    entity - foo::b()
 )");
     }
 }
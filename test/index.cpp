@@ -4,6 +4,8 @@
 
 #include <standardese/index.hpp>
 
+#include <thread>
+
 #include "../external/catch/single_include/catch2/catch.hpp"
 
 #include <cppast/cpp_namespace.hpp>
@@ -184,6 +186,52 @@ using z = int;
     }
 }
 
+TEST_CASE("entity_index duplicates")
+{
+    auto file = parse_file({}, "entity_index_duplicates.cpp", R"(
+namespace ns
+{
+  using a = int;
+}
+)");
+    auto& ns = static_cast<const cppast::cpp_namespace&>(*file->begin());
+    auto& a  = *ns.begin();
+
+    auto get_ns_doc = [&](bool documented) {
+        markup::namespace_documentation::builder builder(type_safe::ref(ns), markup::block_id("ns"),
+                                                         markup::heading::build(markup::block_id(),
+                                                                                "no heading"));
+        if (documented)
+            builder.add_brief(
+                markup::brief_section::builder().add_child(markup::text::build("brief")).finish());
+        return builder;
+    };
+
+    entity_index index;
+    // registered from different threads, so they end up in different buckets
+    std::thread thread([&] {
+        index.register_namespace(ns, get_ns_doc(false));
+        index.register_entity("a", a, nullptr);
+    });
+    thread.join();
+    index.register_entity("a", a, nullptr);
+    index.register_namespace(ns, get_ns_doc(true));
+    index.register_namespace(ns, get_ns_doc(false));
+
+    auto xml = R"(<entity-index id="entity-index">
+<heading>Project index</heading>
+<namespace-documentation id="ns">
+<heading>no heading</heading>
+<brief-section>brief</brief-section>
+<entity-index-item id="a">
+<entity><documentation-link unresolved-destination-id="a"><code>a</code></documentation-link></entity>
+</entity-index-item>
+</namespace-documentation>
+</entity-index>
+)";
+    REQUIRE(markup::as_xml(*index.generate(entity_index::order::namespace_inline_sorted)) == xml);
+}
+
 TEST_CASE("file_index")
 {
     auto brief_doc = markup::brief_section::builder()
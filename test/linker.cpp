@@ -147,6 +147,44 @@ void context3();
         REQUIRE(equal_destination(l.lookup_documentation(type_safe::ref(context3), "*func"),
                                   *document_a, markup::block_id("func")));
     }
+    SECTION("relative name lookup in nested scopes")
+    {
+        auto file = parse_file({}, "linker__relative_name_lookup_nested.cpp", R"(
+namespace a
+{
+    void func();
+
+    namespace b
+    {
+        void func();
+
+        namespace c
+        {
+            struct type
+            {
+                void context();
+            };
+        }
+    }
+}
+)");
+        REQUIRE(l.register_documentation("a::func()", *document_a, markup::block_id("a::func"),
+                                         false));
+        REQUIRE(l.register_documentation("a::b::func()", *document_a,
+                                         markup::block_id("a::b::func"), false));
+        REQUIRE(l.register_documentation("a::b::c::type", *document_a,
+                                         markup::block_id("a::b::c::type"), false));
+        l.freeze();
+
+        link_scopes scopes(type_safe::ref(get_named_entity(*file, "context")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("a::b::func")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "?type"), *document_a,
+                                  markup::block_id("a::b::c::type")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*a::func()"), *document_a,
+                                  markup::block_id("a::func")));
+        REQUIRE(!l.lookup_documentation(scopes, "*context"));
+    }
     SECTION("external doc")
     {
         l.register_external("std", "std/$$/");
@@ -167,4 +205,28 @@ void context3();
 
         REQUIRE(!l.lookup_documentation(nullptr, "std_bar"));
     }
+    SECTION("frozen")
+    {
+        REQUIRE(l.register_documentation("foo()", *document_a, markup::block_id("foo"), false));
+        REQUIRE(l.register_documentation("foo<T>::bar(int).a", *document_a, markup::block_id("bar"),
+                                         false));
+        for (auto i = 0; i != 100; ++i)
+            REQUIRE(l.register_documentation("baz" + std::to_string(i), *document_b,
+                                             markup::block_id("baz" + std::to_string(i)), false));
+
+        REQUIRE(!l.is_frozen());
+        l.freeze();
+        REQUIRE(l.is_frozen());
+
+        REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo"), *document_a,
+                                  markup::block_id("foo")));
+        REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo::bar().a"), *document_a,
+                                  markup::block_id("bar")));
+        for (auto i = 0; i != 100; ++i)
+            REQUIRE(equal_destination(l.lookup_documentation(nullptr, "baz" + std::to_string(i)),
+                                      *document_b, markup::block_id("baz" + std::to_string(i))));
+
+        REQUIRE(!l.lookup_documentation(nullptr, "bar"));
+        REQUIRE(!l.lookup_documentation(nullptr, "baz100"));
+    }
 }
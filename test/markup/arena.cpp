@@ -0,0 +1,69 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/arena.hpp>
+
+#include "../external/catch/single_include/catch2/catch.hpp"
+
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/generator.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+
+using namespace standardese::markup;
+
+namespace
+{
+std::unique_ptr<main_document> build_document()
+{
+    main_document::builder builder("Hello World!", "my-file");
+    builder.add_child(paragraph::builder()
+                          .add_child(text::build("foo"))
+                          .add_child(emphasis::build("bar"))
+                          .finish());
+    return builder.finish();
+}
+} // namespace
+
+TEST_CASE("arena", "[markup]")
+{
+    auto heap_doc = build_document();
+
+    arena a;
+    REQUIRE(a.allocated() == 0u);
+
+    std::unique_ptr<main_document> arena_doc;
+    {
+        arena_scope scope(a);
+        arena_doc = build_document();
+    }
+    auto allocated = a.allocated();
+    REQUIRE(allocated > 0u);
+
+    // entities created outside of the scope don't use the arena
+    auto clone = standardese::markup::clone(*arena_doc);
+    REQUIRE(a.allocated() == allocated);
+
+    REQUIRE(as_html(*arena_doc) == as_html(*heap_doc));
+    REQUIRE(as_html(*clone) == as_html(*heap_doc));
+
+    SECTION("nested scopes")
+    {
+        arena inner;
+        {
+            arena_scope outer_scope(a);
+            {
+                arena_scope inner_scope(inner);
+                build_document();
+            }
+            build_document();
+        }
+        REQUIRE(inner.allocated() > 0u);
+        REQUIRE(a.allocated() == 2 * allocated);
+    }
+
+    // deleting the entities in the arena only runs their destructors
+    arena_doc.reset();
+    REQUIRE(a.allocated() > 0u);
+}
@@ -7,6 +7,7 @@
 #include "../external/catch/single_include/catch2/catch.hpp"
 
 #include <standardese/markup/generator.hpp>
+#include <standardese/markup/link.hpp>
 #include <standardese/markup/paragraph.hpp>
 
 using namespace standardese::markup;
@@ -83,3 +84,30 @@ TEST_CASE("template_document", "[markup]")
     REQUIRE(as_xml(*doc) == xml);
     REQUIRE(as_markdown(*doc) == md);
 }
+
+TEST_CASE("document_entity links", "[markup]")
+{
+    paragraph::builder p1;
+    p1.add_child(text::build("foo"));
+    p1.add_child(documentation_link::builder("a").add_child(text::build("a")).finish());
+
+    paragraph::builder p2;
+    p2.add_child(emphasis::build("bar"));
+    p2.add_child(documentation_link::builder("b").add_child(text::build("b")).finish());
+
+    subdocument::builder builder("Hello World!", "my-file");
+    builder.add_child(p1.finish());
+    builder.add_child(p2.finish());
+
+    auto check = [](const document_entity& doc) {
+        REQUIRE(doc.documentations().empty());
+        REQUIRE(doc.links().size() == 2u);
+        REQUIRE(doc.links()[0u]->unresolved_destination().value() == "a");
+        REQUIRE(doc.links()[1u]->unresolved_destination().value() == "b");
+        REQUIRE(&doc.links()[0u]->parent().value().parent().value() == &doc);
+    };
+
+    auto doc = builder.finish();
+    check(*doc);
+    check(*standardese::markup::clone(*doc));
+}
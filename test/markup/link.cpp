@@ -108,4 +108,12 @@ TEST_CASE("documentation_link", "[markup]")
         == R"(<documentation-link destination-url="http://foonathan.net">link 4</documentation-link>)");
     REQUIRE(as_markdown(*ptr3) == R"([link 4](http://foonathan.net)
 )");
+
+    // unresolved link in code, only the content is written
+    code::builder code;
+    code.add_child(text::build("foo "));
+    code.add_child(documentation_link::builder("bar").add_child(text::build("bar")).finish());
+
+    auto ptr4 = code.finish();
+    REQUIRE(as_markdown(*ptr4) == "`foo bar`\n");
 }
@@ -8,7 +8,9 @@
 
 #include <algorithm>
 
+#include <standardese/markup/doc_section.hpp>
 #include <standardese/markup/generator.hpp>
+#include <standardese/markup/link.hpp>
 #include <standardese/markup/paragraph.hpp>
 
 using namespace standardese::markup;
@@ -110,3 +112,58 @@ TEST_CASE("ordered_list", "[markup]")
     REQUIRE(as_xml(*ptr) == xml);
     REQUIRE(as_markdown(*ptr) == md);
 }
+
+TEST_CASE("description from brief", "[markup]")
+{
+    auto build_brief = [](bool with_link) {
+        brief_section::builder builder;
+        builder.add_child(text::build("A "));
+        if (with_link)
+            builder.add_child(
+                documentation_link::builder("foo").add_child(text::build("foo")).finish());
+        else
+            builder.add_child(emphasis::build("foo"));
+        return builder.finish();
+    };
+
+    auto first_child = [](const description& desc) { return &*desc.begin(); };
+
+    description::builder expected;
+    expected.add_child(text::build("A "));
+    expected.add_child(emphasis::build("foo"));
+    auto xml = as_xml(*expected.finish());
+
+    SECTION("unique")
+    {
+        auto brief = build_brief(false);
+        auto desc  = description::build(*brief);
+        REQUIRE(as_xml(*desc) == xml);
+        REQUIRE(first_child(*desc) != &*brief->begin());
+        REQUIRE(&first_child(*desc)->parent().value() == desc.get());
+    }
+    SECTION("shared")
+    {
+        std::shared_ptr<const brief_section> brief = build_brief(false);
+        auto                                 desc  = description::build(*brief);
+        REQUIRE(as_xml(*desc) == xml);
+        REQUIRE(first_child(*desc) == &*brief->begin());
+        REQUIRE(brief.use_count() == 2);
+
+        auto clone = standardese::markup::clone(*desc);
+        REQUIRE(first_child(*clone) == &*brief->begin());
+        REQUIRE(brief.use_count() == 3);
+
+        // the description keeps the brief alive
+        auto ptr = brief.get();
+        brief.reset();
+        REQUIRE(first_child(*desc) == &*ptr->begin());
+        REQUIRE(as_xml(*clone) == xml);
+    }
+    SECTION("shared with link")
+    {
+        std::shared_ptr<const brief_section> brief = build_brief(true);
+        auto                                 desc  = description::build(*brief);
+        REQUIRE(first_child(*desc) != &*brief->begin());
+        REQUIRE(brief.use_count() == 1);
+    }
+}
@@ -0,0 +1,48 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "../../tool/generator.hpp"
+
+#include "../../external/catch/single_include/catch2/catch.hpp"
+
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+
+using namespace standardese::markup;
+
+namespace
+{
+standardese_tool::documents build_documents(const char* title, const char* file)
+{
+    standardese_tool::documents result;
+    result.arenas.push_back(std::make_unique<arena>());
+
+    arena_scope            scope(*result.arenas.back());
+    main_document::builder builder(title, file);
+    builder.add_child(paragraph::builder().add_child(text::build("foo")).finish());
+    result.entities.push_back(builder.finish());
+    return result;
+}
+} // namespace
+
+TEST_CASE("documents", "[tool]")
+{
+    auto docs = build_documents("A", "a");
+    REQUIRE(docs.arenas.size() == 1u);
+    REQUIRE(docs.entities.size() == 1u);
+
+    // the old documents must be destroyed before their arena
+    docs = build_documents("B", "b");
+    REQUIRE(docs.arenas.size() == 1u);
+    REQUIRE(docs.entities.size() == 1u);
+    REQUIRE(docs.entities.front()->output_name().name() == "b");
+
+    auto moved = std::move(docs);
+    REQUIRE(moved.entities.size() == 1u);
+    REQUIRE(as_html(*moved.entities.front()).find("foo") != std::string::npos);
+
+    moved = standardese_tool::documents();
+    REQUIRE(moved.arenas.empty());
+    REQUIRE(moved.entities.empty());
+}
@@ -4,47 +4,81 @@
 
 #include "generator.hpp"
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include <cppast/cpp_preprocessor.hpp>
+#include <cppast/visitor.hpp>
 
 #include <standardese/index.hpp>
 #include <standardese/linker.hpp>
 
-#include "thread_pool.hpp"
-
 using namespace standardese_tool;
 
 type_safe::optional<std::vector<parsed_file>> standardese_tool::parse(
     const cppast::libclang_compile_config&                            config,
     const type_safe::optional<cppast::libclang_compilation_database>& database,
-    const std::vector<input_file>& files, const cppast::cpp_entity_index& index,
-    unsigned no_threads)
+    bool fast_preprocessing, const std::vector<input_file>& files,
+    const cppast::cpp_entity_index& index, const standardese::file_comment_parser& comments,
+    thread_pool& pool, type_safe::optional_ref<profiler> profile)
 {
+    profile_span stage(profile, "parsing");
+
     std::vector<parsed_file> result;
     bool                     error(false);
     cppast::libclang_parser  parser(cppast::default_logger());
 
+    // the jobs are run in order, so start with the biggest files,
+    // otherwise the parsing of a big file might start only when all the other threads are idle
+    std::vector<std::pair<std::uintmax_t, const input_file*>> by_size;
+    for (auto& file : files)
     {
-        std::mutex  mutex;
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-        {
-            add_job(pool, [&, file] {
-                auto db_config = database.map([&](const cppast::libclang_compilation_database& db) {
-                    return cppast::find_config_for(db, file.path.generic_string());
-                });
+        boost::system::error_code ec;
+        auto                      size = fs::file_size(file.path, ec);
+        by_size.emplace_back(ec ? 0u : size, &file);
+    }
+    std::stable_sort(by_size.begin(), by_size.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    std::mutex                     mutex;
+    std::vector<std::future<void>> jobs;
+    for (auto& entry : by_size)
+    {
+        jobs.push_back(add_job(pool, [&, file = *entry.second] {
+            auto db_config = database.map([&](const cppast::libclang_compilation_database& db) {
+                auto file_config = cppast::find_config_for(db, file.path.generic_string());
+                if (fast_preprocessing)
+                    file_config.fast_preprocessing(true);
+                return file_config;
+            });
+
+            auto actual_config = db_config.value_or(config);
 
-                auto actual_config = db_config.value_or(config);
-                auto parsed
+            std::unique_ptr<cppast::cpp_file> parsed;
+            {
+                profile_span span(profile, "libclang parse", file.relative.generic_string());
+                parsed
                     = parser.parse(index, fs::canonical(file.path).generic_string(), actual_config);
+            }
+            if (parsed)
+            {
+                profile_span span(profile, "comment parse", file.relative.generic_string());
+                // no need to wait for the other files
+                comments.parse(type_safe::ref(*parsed));
+            }
 
-                std::lock_guard<std::mutex> lock(mutex);
-                if (parsed)
-                    result.push_back({std::move(parsed), file.relative.generic_string()});
-                else
-                    error = true;
-            });
-        }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (parsed)
+                result.push_back({std::move(parsed), file.relative.generic_string()});
+            else
+                error = true;
+        }));
     }
+    wait_for(jobs);
 
     if (error)
         return type_safe::nullopt;
@@ -52,46 +86,59 @@ type_safe::optional<std::vector<parsed_file>> standardese_tool::parse(
         return std::move(result);
 }
 
-standardese::comment_registry standardese_tool::parse_comments(
-    const standardese::comment::config& config, const std::vector<parsed_file>& files,
-    unsigned no_threads)
-{
-    standardese::file_comment_parser parser(cppast::default_logger(), config);
-    {
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool, [&file, &parser] { parser.parse(type_safe::ref(*file.file)); });
-    }
-    return parser.finish();
-}
-
 std::vector<std::unique_ptr<standardese::doc_cpp_file>> standardese_tool::build_files(
     const standardese::comment_registry& registry, const cppast::cpp_entity_index& index,
     std::vector<parsed_file>&& files, const standardese::entity_blacklist& blacklist,
-    bool hide_uncommented, unsigned no_threads)
+    bool hide_uncommented, thread_pool& pool, type_safe::optional_ref<profiler> profile)
 {
-    {
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool,
-                    [&] { standardese::exclude_entities(registry, index, blacklist, hide_uncommented, *file.file); });
-    }
+    profile_span stage(profile, "building entities");
+
+    std::vector<std::future<void>> jobs;
+
+    // all files need to be excluded before building,
+    // as it checks whether entities of other files are excluded
+    for (auto& file : files)
+        jobs.push_back(add_job(pool, [&] {
+            {
+                profile_span span(profile, "exclude", file.output_name);
+                standardese::exclude_entities(registry, index, blacklist, hide_uncommented,
+                                              *file.file);
+            }
+
+            if (profile)
+            {
+                std::uint64_t entities = 0u, comments = 0u;
+                cppast::visit(*file.file, [&](const cppast::cpp_entity& e,
+                                              const cppast::visitor_info& info) {
+                    if (info.event != cppast::visitor_info::container_entity_exit)
+                    {
+                        ++entities;
+                        if (registry.get_comment(e))
+                            ++comments;
+                    }
+                    return true;
+                });
+                profile.value().count("entities", entities);
+                profile.value().count("comments", comments);
+            }
+        }));
+    wait_for(jobs);
 
     std::vector<std::unique_ptr<standardese::doc_cpp_file>> result;
 
-    {
-        std::mutex  mutex;
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool, [&] {
-                auto entity = standardese::build_doc_entities(type_safe::ref(registry), index,
-                                                              std::move(file.file),
-                                                              std::move(file.output_name));
-
-                std::lock_guard<std::mutex> lock(mutex);
-                result.push_back(std::move(entity));
-            });
-    }
+    std::mutex mutex;
+    for (auto& file : files)
+        jobs.push_back(add_job(pool, [&] {
+            profile_span span(profile, "doc_entity build", file.output_name);
+
+            auto entity = standardese::build_doc_entities(type_safe::ref(registry), index,
+                                                          std::move(file.file),
+                                                          std::move(file.output_name));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            result.push_back(std::move(entity));
+        }));
+    wait_for(jobs);
 
     return result;
 }
@@ -110,72 +157,472 @@ std::unique_ptr<standardese::markup::document_entity> get_index_document(
 documents standardese_tool::generate(
     const standardese::generation_config& gen_config,
     const standardese::synopsis_config& syn_config, const standardese::comment_registry& comments,
-    const cppast::cpp_entity_index& index, const standardese::linker& linker,
-    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files, unsigned no_threads)
+    const cppast::cpp_entity_index& index, standardese::linker& linker,
+    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files, thread_pool& pool,
+    type_safe::optional_ref<profiler> profile)
 {
-    std::mutex                                                         result_mutex;
-    std::vector<std::unique_ptr<standardese::markup::document_entity>> result;
+    profile_span stage(profile, "generating documentation");
+
+    std::mutex result_mutex;
+    documents  result;
 
     standardese::entity_index eindex;
     standardese::file_index   findex;
     standardese::module_index mindex;
 
-    {
-        thread_pool pool(no_threads);
-
-        std::vector<std::future<void>> futures;
-        for (auto& file : files)
-            futures.push_back(add_job(pool, [&] {
-                standardese::markup::subdocument::builder document(file->output_name(),
-                                                                   "doc_"
-                                                                       + get_output_file_name(
-                                                                             file->output_name()));
+    std::vector<std::future<void>> jobs;
+    for (auto& file : files)
+        jobs.push_back(add_job(pool, [&] {
+            // the hundreds of entities of a document are allocated from a single arena,
+            // so freeing the document doesn't have to free them one by one
+            auto arena = std::make_unique<standardese::markup::arena>();
+
+            std::unique_ptr<standardese::markup::subdocument> finished_doc;
+            {
+                profile_span span(profile, "markup generation", file->output_name());
+                standardese::markup::arena_scope scope(*arena);
+
+                standardese::markup::subdocument::builder
+                    document(file->output_name(),
+                             "doc_" + get_output_file_name(file->output_name()));
                 document.add_child(
                     standardese::generate_documentation(gen_config, syn_config, index, *file));
-                auto finished_doc = document.finish();
+                finished_doc = document.finish();
+            }
 
+            {
+                profile_span span(profile, "link registration", file->output_name());
                 standardese::register_documentations(*cppast::default_logger(), linker,
                                                      *finished_doc);
-                standardese::register_index_entities(eindex, file->file());
-                standardese::register_module_entities(mindex, comments, file->file());
-                findex.register_file(file->link_name(), file->output_name(),
-                                     file->comment() ? file->comment().value().brief_section()
-                                                     : nullptr);
-
-                std::lock_guard<std::mutex> lock(result_mutex);
-                result.push_back(std::move(finished_doc));
-            }));
-
-        for (auto& future : futures)
-            future.get(); // to retrieve exceptions
+            }
+            standardese::register_index_entities(eindex, file->file());
+            standardese::register_module_entities(mindex, comments, file->file());
+            findex.register_file(file->link_name(), file->output_name(),
+                                 file->comment() ? file->comment().value().brief_section()
+                                                 : nullptr);
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            result.arenas.push_back(std::move(arena));
+            result.entities.push_back(std::move(finished_doc));
+        }));
+    wait_for(jobs);
+
+    // the index documents are generated in parallel,
+    // but registered and appended in a fixed order, so the output and diagnostics are the same
+    std::unique_ptr<standardese::markup::document_entity> index_docs[3];
+    auto add_index_document = [&](std::size_t i, auto generate_index, const char* title,
+                                  const char* name) {
+        jobs.push_back(add_job(pool, [&, i, generate_index, title, name] {
+            profile_span span(profile, "index generation", name);
+            index_docs[i] = get_index_document(generate_index(), title, name);
+        }));
+    };
+    add_index_document(0u, [&] { return eindex.generate(gen_config.order()); }, "Entities",
+                       "standardese_entities");
+    add_index_document(1u, [&] { return findex.generate(); }, "Files", "standardese_files");
+    add_index_document(2u, [&] { return mindex.generate(); }, "Modules", "standardese_modules");
+    wait_for(jobs);
+
+    for (auto& doc : index_docs)
+    {
+        standardese::register_documentations(*cppast::default_logger(), linker, *doc);
+        result.entities.push_back(std::move(doc));
     }
 
-    auto eindex_doc = get_index_document(eindex.generate(gen_config.order()), "Entities",
-                                         "standardese_entities");
-    standardese::register_documentations(*cppast::default_logger(), linker, *eindex_doc);
-    result.push_back(std::move(eindex_doc));
+    // the linker is fully populated now, so every document can be resolved independently
+    linker.freeze();
+    for (auto& doc : result.entities)
+        jobs.push_back(add_job(pool, [&] {
+            profile_span span(profile, "link resolution", doc->output_name().name());
+            standardese::resolve_links(*cppast::default_logger(), linker, *doc);
+            if (profile)
+                profile.value().count("links", doc->links().size());
+        }));
+    wait_for(jobs);
 
-    auto findex_doc = get_index_document(findex.generate(), "Files", "standardese_files");
-    standardese::register_documentations(*cppast::default_logger(), linker, *findex_doc);
-    result.push_back(std::move(findex_doc));
+    return result;
+}
 
-    auto mindex_doc = get_index_document(mindex.generate(), "Modules", "standardese_modules");
-    standardese::register_documentations(*cppast::default_logger(), linker, *mindex_doc);
-    result.push_back(std::move(mindex_doc));
+namespace
+{
+// FNV-1a, no need for anything cryptographic here
+std::uint64_t hash_content(const std::string& content)
+{
+    auto hash = 14695981039346656037ull;
+    for (auto c : content)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
 
-    for (auto& doc : result)
-        standardese::resolve_links(*cppast::default_logger(), linker, *doc);
+// hash of the file content, or zero if it can't be read
+std::uint64_t hash_file(const fs::path& path)
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    if (!file)
+        return 0u;
+
+    std::string content(std::istreambuf_iterator<char>(file), {});
+    return hash_content(content);
+}
+
+struct scanned_include
+{
+    std::string name; // empty if the include is computed by a macro
+    bool        quoted;
+};
+
+// the #include directives of a file, including those in disabled conditionals
+std::vector<scanned_include> scan_includes(const fs::path& path)
+{
+    std::vector<scanned_include> result;
+
+    std::ifstream file(path.string());
+    for (std::string line; std::getline(file, line);)
+    {
+        auto pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')
+            continue;
+        pos = line.find_first_not_of(" \t", pos + 1u);
+        if (pos == std::string::npos || line.compare(pos, 7u, "include") != 0)
+            continue;
+        pos += 7u;
+        if (line.compare(pos, 5u, "_next") == 0)
+            pos += 5u;
+
+        pos = line.find_first_not_of(" \t", pos);
+        if (pos == std::string::npos || (line[pos] != '"' && line[pos] != '<'))
+            result.push_back({"", false});
+        else
+        {
+            auto quoted = line[pos] == '"';
+            auto end    = line.find(quoted ? '"' : '>', pos + 1u);
+            if (end != std::string::npos)
+                result.push_back({line.substr(pos + 1u, end - pos - 1u), quoted});
+        }
+    }
 
     return result;
 }
 
-void standardese_tool::write_files(const documents& docs, standardese::markup::generator generator,
-                                   std::string prefix, const char* extension, unsigned no_threads)
+// searches an included file like the preprocessor does, returns an empty path if not found
+fs::path resolve_include(const scanned_include& include, const fs::path& includer,
+                         const std::vector<fs::path>& include_dirs)
+{
+    auto exists = [](const fs::path& path) {
+        boost::system::error_code ec;
+        return fs::is_regular_file(path, ec);
+    };
+
+    fs::path name(include.name);
+    if (name.is_absolute())
+        return exists(name) ? name : fs::path();
+    else if (include.quoted && exists(includer.parent_path() / name))
+        return includer.parent_path() / name;
+
+    for (auto& dir : include_dirs)
+        if (exists(dir / name))
+            return dir / name;
+    return fs::path();
+}
+
+bool has_content(const fs::path& path, const std::string& content)
+{
+    std::ifstream file(path.string());
+    if (!file)
+        return false;
+
+    std::string existing(std::istreambuf_iterator<char>(file), {});
+    return existing == content;
+}
+
+// writes the content into a temporary file and renames it to `path`,
+// so an incomplete file never replaces the previous one
+template <typename Func>
+void write_atomically(const fs::path& path, Func write_content)
+{
+    auto tmp = path;
+    tmp += ".tmp";
+
+    std::ofstream file(tmp.string());
+    write_content(file);
+    file.close();
+    if (!file)
+    {
+        boost::system::error_code ec;
+        fs::remove(tmp, ec);
+        throw std::runtime_error("unable to write '" + path.generic_string() + "'");
+    }
+
+    fs::rename(tmp, path);
+}
+} // namespace
+
+output_manifest::output_manifest(fs::path path, std::vector<std::string> prefixes)
+: path_(std::move(path)), prefixes_(std::move(prefixes))
+{
+    std::ifstream file(path_.string());
+
+    std::uint64_t hash;
+    std::string   output;
+    while (file >> std::hex >> hash && std::getline(file >> std::ws, output))
+        // a manifest of another run or a corrupted one must not make us remove arbitrary files
+        if (is_owned(output))
+            previous_.emplace(std::move(output), hash);
+}
+
+bool output_manifest::is_owned(const std::string& output) const
+{
+    for (auto& prefix : prefixes_)
+        if (output.size() > prefix.size() && output.compare(0, prefix.size(), prefix) == 0)
+        {
+            auto name = output.substr(prefix.size());
+            return name != "." && name != ".." && name.find_first_of("/\\:") == std::string::npos;
+        }
+    return false;
+}
+
+bool output_manifest::write(const fs::path& path, const std::string& content)
+{
+    auto hash = hash_content(content);
+
+    auto unchanged = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        iter = previous_.find(path.generic_string());
+        unchanged = iter != previous_.end() && iter->second == hash;
+    }
+
+    // the manifest saves reading the file, otherwise compare with what is there
+    auto written = false;
+    if (unchanged ? !fs::exists(path) : !has_content(path, content))
+    {
+        write_atomically(path, [&](std::ostream& out) { out << content; });
+        written = true;
+    }
+
+    // only record the hash once the file has that content
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_[path.generic_string()] = hash;
+    return written;
+}
+
+std::size_t output_manifest::finish()
+{
+    std::size_t removed = 0;
+    for (auto& output : previous_)
+        if (current_.count(output.first) == 0u && is_owned(output.first))
+        {
+            boost::system::error_code ec;
+            if (fs::remove(output.first, ec))
+                ++removed;
+        }
+
+    std::vector<std::pair<std::string, std::uint64_t>> sorted(current_.begin(), current_.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    if (path_.has_parent_path())
+        fs::create_directories(path_.parent_path());
+    write_atomically(path_, [&](std::ostream& out) {
+        for (auto& output : sorted)
+            out << std::hex << output.second << ' ' << output.first << '\n';
+    });
+
+    previous_ = std::move(current_);
+    current_.clear();
+    return removed;
+}
+
+bool output_manifest::has_previous_outputs() const
+{
+    if (previous_.empty())
+        return false;
+
+    for (auto& output : previous_)
+        if (!fs::exists(output.first))
+            return false;
+    return true;
+}
+
+input_cache::input_cache(fs::path directory, const std::string& options,
+                         std::vector<fs::path> include_dirs)
+: path_(std::move(directory) / "inputs"),
+  options_(hash_content(options)),
+  include_dirs_(std::move(include_dirs)),
+  complete_(true)
+{
+    std::ifstream file(path_.string());
+
+    std::string   kind, path;
+    std::uint64_t hash;
+    while (file >> kind >> std::hex >> hash && std::getline(file >> std::ws, path))
+        if (kind == "options")
+            previous_options_ = hash;
+        else if (kind == "file")
+            previous_files_.emplace(std::move(path), hash);
+        else if (kind == "include")
+            previous_includes_.emplace(std::move(path), hash);
+}
+
+bool input_cache::is_unchanged(const std::vector<input_file>& files) const
+{
+    if (previous_options_ != options_ || files.size() != previous_files_.size())
+        return false;
+
+    for (auto& file : files)
+    {
+        auto iter = previous_files_.find(fs::canonical(file.path).generic_string());
+        if (iter == previous_files_.end() || iter->second != hash_file(iter->first))
+            return false;
+    }
+
+    for (auto& include : previous_includes_)
+        if (include.second != hash_file(include.first))
+            return false;
+
+    return true;
+}
+
+void input_cache::record(const std::vector<parsed_file>& files)
 {
-    thread_pool pool(no_threads);
-    for (auto& doc : docs)
-        add_job(pool, [&] {
-            std::ofstream file(prefix + doc->output_name().file_name(extension));
-            generator(file, *doc);
-        });
+    current_files_.clear();
+    current_includes_.clear();
+    complete_ = true;
+
+    std::vector<fs::path> pending;
+    auto                  add_include = [&](const fs::path& path) {
+        if (current_includes_.emplace(path.generic_string(), hash_file(path)).second)
+            pending.push_back(path);
+    };
+
+    // the direct includes were found by libclang, the directories they were found in are
+    // searched for the indirect ones as well, as they might come from a compilation database
+    auto include_dirs = include_dirs_;
+    for (auto& file : files)
+    {
+        current_files_.emplace(file.file->name(), hash_file(file.file->name()));
+        for (auto& entity : *file.file)
+            if (entity.kind() == cppast::cpp_include_directive::kind())
+            {
+                auto& include = static_cast<const cppast::cpp_include_directive&>(entity);
+                if (include.full_path().empty())
+                    continue;
+                add_include(include.full_path());
+
+                auto full_path = fs::path(include.full_path()).generic_string();
+                auto name      = fs::path(include.name()).generic_string();
+                if (full_path.size() > name.size() + 1u
+                    && full_path.compare(full_path.size() - name.size(), name.size(), name) == 0
+                    && full_path[full_path.size() - name.size() - 1u] == '/')
+                {
+                    fs::path dir = full_path.substr(0u, full_path.size() - name.size() - 1u);
+                    if (std::find(include_dirs.begin(), include_dirs.end(), dir)
+                        == include_dirs.end())
+                        include_dirs.push_back(std::move(dir));
+                }
+            }
+    }
+
+    // changes to any file included in turn can change the meaning of the file as well
+    while (!pending.empty())
+    {
+        auto header = std::move(pending.back());
+        pending.pop_back();
+
+        for (auto& include : scan_includes(header))
+        {
+            auto path = include.name.empty() ? fs::path()
+                                              : resolve_include(include, header, include_dirs);
+            if (!path.empty())
+                add_include(path);
+            else if (include.quoted || include.name.empty())
+                // a change of that file can't be detected
+                complete_ = false;
+        }
+    }
+}
+
+void input_cache::save()
+{
+    auto write_sorted = [](std::ostream& out, const char* kind,
+                           const std::unordered_map<std::string, std::uint64_t>& hashes) {
+        std::vector<std::pair<std::string, std::uint64_t>> sorted(hashes.begin(), hashes.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (auto& entry : sorted)
+            out << kind << ' ' << std::hex << entry.second << ' ' << entry.first << '\n';
+    };
+
+    if (!complete_)
+    {
+        // without hashes the next run parses again
+        boost::system::error_code ec;
+        fs::remove(path_, ec);
+        previous_options_.reset();
+        previous_files_.clear();
+        previous_includes_.clear();
+        return;
+    }
+
+    fs::create_directories(path_.parent_path());
+
+    auto tmp = path_;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp.string());
+        file << "options " << std::hex << options_ << " -\n";
+        write_sorted(file, "file", current_files_);
+        write_sorted(file, "include", current_includes_);
+    }
+    fs::rename(tmp, path_);
+
+    previous_options_  = options_;
+    previous_files_    = std::move(current_files_);
+    previous_includes_ = std::move(current_includes_);
+    current_files_.clear();
+    current_includes_.clear();
+}
+
+void standardese_tool::write_files(const documents& docs, const std::vector<output_format>& formats,
+                                   thread_pool&                             pool,
+                                   type_safe::optional_ref<output_manifest> manifest,
+                                   type_safe::optional_ref<profiler>        profile)
+{
+    profile_span stage(profile, "writing files");
+
+    std::vector<std::future<void>> jobs;
+    for (auto& doc : docs.entities)
+        jobs.push_back(add_job(pool, [&] {
+            // all formats at once, while the document is still in the cache
+            std::ostringstream stream;
+            for (auto& format : formats)
+            {
+                auto path = format.prefix + doc->output_name().file_name(format.extension);
+
+                profile_span span(profile, "write", path);
+
+                std::uint64_t bytes = 0u;
+                if (manifest)
+                {
+                    stream.str("");
+                    format.generator(stream, *doc);
+                    auto content = stream.str();
+                    // unchanged files aren't written, so they don't count
+                    if (manifest.value().write(path, content))
+                        bytes = content.size();
+                }
+                else
+                {
+                    std::ofstream file(path);
+                    format.generator(file, *doc);
+                    if (file.tellp() > 0)
+                        bytes = std::uint64_t(file.tellp());
+                }
+
+                if (profile)
+                    profile.value().count("bytes written", bytes);
+            }
+        }));
+    wait_for(jobs);
 }
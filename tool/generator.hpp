@@ -5,6 +5,10 @@
 #ifndef STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
 #define STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
 
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <cppast/cpp_entity_index.hpp>
@@ -14,10 +18,13 @@
 #include <standardese/comment.hpp>
 #include <standardese/doc_entity.hpp>
 #include <standardese/linker.hpp>
+#include <standardese/markup/arena.hpp>
 #include <standardese/markup/document.hpp>
 #include <standardese/markup/generator.hpp>
 
 #include "filesystem.hpp"
+#include "profiler.hpp"
+#include "thread_pool.hpp"
 
 namespace standardese_tool
 {
@@ -33,32 +40,149 @@ struct parsed_file
     std::string                       output_name;
 };
 
+/// Parses the files and their documentation comments.
+/// The comments of a file are parsed as soon as the file itself has been parsed,
+/// they are registered in `comments`.
+/// If `fast_preprocessing` is set, it is also used for the configurations of the database.
+/// If a profiler is given, the parsing of each file is recorded in it,
+/// as are the parsing and exclusion, building, generation and writing of the other functions.
 type_safe::optional<std::vector<parsed_file>> parse(
     const cppast::libclang_compile_config&                            config,
     const type_safe::optional<cppast::libclang_compilation_database>& database,
-    const std::vector<input_file>& files, const cppast::cpp_entity_index& index,
-    unsigned no_threads);
-
-standardese::comment_registry parse_comments(const standardese::comment::config& config,
-                                             const std::vector<parsed_file>&     files,
-                                             unsigned                            no_threads);
+    bool fast_preprocessing, const std::vector<input_file>& files,
+    const cppast::cpp_entity_index& index, const standardese::file_comment_parser& comments,
+    thread_pool& pool, type_safe::optional_ref<profiler> profile = nullptr);
 
 std::vector<std::unique_ptr<standardese::doc_cpp_file>> build_files(
     const standardese::comment_registry& registry, const cppast::cpp_entity_index& index,
     std::vector<parsed_file>&& files, const standardese::entity_blacklist& blacklist,
-    bool hide_uncommented, unsigned no_threads);
+    bool hide_uncommented, thread_pool& pool, type_safe::optional_ref<profiler> profile = nullptr);
+
+/// The generated documents.
+/// \notes The documents are always destroyed before the arenas they are allocated from.
+struct documents
+{
+    std::vector<std::unique_ptr<standardese::markup::arena>>           arenas;
+    std::vector<std::unique_ptr<standardese::markup::document_entity>> entities;
+
+    documents() = default;
 
-using documents = std::vector<std::unique_ptr<standardese::markup::document_entity>>;
+    documents(documents&&) noexcept = default;
+
+    ~documents() noexcept
+    {
+        entities.clear();
+    }
+
+    documents& operator=(documents&& other) noexcept
+    {
+        if (this != &other)
+        {
+            // the implicit move assignment would free the old arenas first
+            entities.clear();
+            arenas   = std::move(other.arenas);
+            entities = std::move(other.entities);
+        }
+        return *this;
+    }
+};
 
 documents generate(const standardese::generation_config& gen_config,
                    const standardese::synopsis_config&   syn_config,
                    const standardese::comment_registry&  comments,
-                   const cppast::cpp_entity_index& index, const standardese::linker& linker,
+                   const cppast::cpp_entity_index& index, standardese::linker& linker,
                    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files,
-                   unsigned                                                       no_threads);
+                   thread_pool& pool, type_safe::optional_ref<profiler> profile = nullptr);
+
+/// The hashes of the output files written by the tool.
+///
+/// It is used to only replace the output files whose content has changed,
+/// and to remove the output files of a previous run that aren't generated anymore.
+/// It only ever removes files directly named by one of its prefixes,
+/// so runs with other prefixes writing into the same directory are left alone.
+class output_manifest
+{
+public:
+    /// \effects Reads the manifest of the previous run from the given file, if there is one.
+    /// Entries that don't belong to one of the output `prefixes` are ignored.
+    output_manifest(fs::path path, std::vector<std::string> prefixes);
+
+    /// \effects Writes `content` into the file at `path`, unless it has that content already.
+    /// The file is replaced atomically by renaming a temporary file.
+    /// \returns Whether or not the file was written.
+    /// \throws `std::runtime_error` if the file couldn't be written,
+    /// the previous file is kept then.
+    /// \notes This function is thread safe.
+    bool write(const fs::path& path, const std::string& content);
+
+    /// \effects Removes all files of the previous run that were not written in this one,
+    /// and saves the manifest for the next run.
+    /// \returns The number of removed files.
+    std::size_t finish();
+
+    /// \returns Whether or not there was a previous run and all of its files still exist.
+    bool has_previous_outputs() const;
+
+private:
+    // whether the output is a file directly named by one of the prefixes
+    bool is_owned(const std::string& output) const;
+
+    fs::path                                        path_;
+    std::vector<std::string>                        prefixes_;
+    std::mutex                                      mutex_;
+    std::unordered_map<std::string, std::uint64_t> previous_, current_;
+};
+
+/// The hashes of the inputs of the previous run.
+///
+/// If neither the input files, nor the files they include, nor the options have changed,
+/// the documentation generated by the previous run is still up to date.
+class input_cache
+{
+public:
+    /// \effects Reads the hashes of the previous run from the given directory, if there are any.
+    /// `options` is everything besides the input files that affects the documentation,
+    /// `include_dirs` are the directories where included files are searched.
+    input_cache(fs::path directory, const std::string& options,
+                std::vector<fs::path> include_dirs);
+
+    /// \returns Whether or not the input files, the files they include and the options
+    /// are the same as in the previous run.
+    bool is_unchanged(const std::vector<input_file>& files) const;
+
+    /// \effects Hashes the parsed files and all files they include, directly or indirectly.
+    /// \notes Files included with angle brackets that can't be found are considered system headers
+    /// that don't change.
+    /// If another include can't be found, the next run can't be skipped.
+    void record(const std::vector<parsed_file>& files);
+
+    /// \effects Saves the recorded hashes for the next run.
+    void save();
+
+private:
+    fs::path                                        path_;
+    std::uint64_t                                   options_;
+    std::vector<fs::path>                           include_dirs_;
+    std::unordered_map<std::string, std::uint64_t> previous_files_, previous_includes_;
+    std::unordered_map<std::string, std::uint64_t> current_files_, current_includes_;
+    type_safe::optional<std::uint64_t>              previous_options_;
+    bool                                            complete_;
+};
+
+/// An output format of the documents.
+struct output_format
+{
+    standardese::markup::generator generator;
+    const char*                    extension;
+    std::string                    prefix;
+};
 
-void write_files(const documents& docs, standardese::markup::generator generator,
-                 std::string prefix, const char* extension, unsigned no_threads);
+/// Writes the documents in all the formats.
+/// Each document is written in every format by the same job, one format after the other.
+/// If a manifest is given, only the files whose content changed are written.
+void write_files(const documents& docs, const std::vector<output_format>& formats,
+                 thread_pool& pool, type_safe::optional_ref<output_manifest> manifest = nullptr,
+                 type_safe::optional_ref<profiler> profile = nullptr);
 } // namespace standardese_tool
 
 #endif // STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
@@ -3,14 +3,18 @@
 // This file is subject to the license terms in the LICENSE file
 // found in the top-level directory of this distribution.
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 
 #include <boost/program_options.hpp>
 
 #include "filesystem.hpp"
 #include "generator.hpp"
 #include "thread_pool.hpp"
+#include "watcher.hpp"
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
@@ -139,6 +143,8 @@ cppast::libclang_compile_config get_compile_config(const po::variables_map& opti
     auto standard = parse_standard(options.at("compilation.standard").as<std::string>());
     config.set_flags(standard, flags);
 
+    config.fast_preprocessing(get_option<bool>(options, "compilation.fast_preprocessing").value());
+
     if (auto includes = get_option<std::vector<std::string>>(options, "compilation.include_dir"))
         for (auto& include : includes.value())
             config.add_include_dir(include);
@@ -201,6 +207,67 @@ std::vector<standardese_tool::input_file> get_input(const po::variables_map& opt
     return files;
 }
 
+// logs the time each stage of a run takes
+class stage_timer
+{
+public:
+    explicit stage_timer(bool enabled) : start_(clock::now()), enabled_(enabled) {}
+
+    // logs the time since the previous stage finished
+    void finish_stage(const char* name)
+    {
+        auto now = clock::now();
+        if (enabled_)
+            std::clog << "  " << name << " took "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count()
+                      << "ms\n";
+        start_ = now;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point start_;
+    bool              enabled_;
+};
+
+// everything besides the input files that affects the generated documentation
+std::string get_cache_options(int argc, char* argv[], const po::variables_map& options)
+{
+    auto read_file = [](const fs::path& path) {
+        std::ifstream file(path.string());
+        return std::string(std::istreambuf_iterator<char>(file), {});
+    };
+
+    std::string result = std::to_string(STANDARDESE_VERSION_MAJOR) + '.'
+                         + std::to_string(STANDARDESE_VERSION_MINOR) + '\n';
+    for (auto i = 1; i < argc; ++i)
+        result += std::string(argv[i]) + '\n';
+    if (auto config = get_option<fs::path>(options, "config"))
+        result += read_file(config.value());
+    if (auto dir = get_option<std::string>(options, "compilation.commands_dir"))
+        result += read_file(fs::path(dir.value()) / "compile_commands.json");
+    return result;
+}
+
+// the directories of all input files and the input directories themselves
+std::vector<fs::path> get_watched_directories(
+    const po::variables_map& options, const std::vector<standardese_tool::input_file>& input)
+{
+    std::vector<fs::path> result;
+    for (auto& path : get_option<std::vector<fs::path>>(options, "input-files").value())
+        result.push_back(fs::is_directory(path) ? path : path.parent_path());
+    for (auto& file : input)
+        result.push_back(file.path.parent_path());
+
+    for (auto& dir : result)
+        if (dir.empty())
+            dir = ".";
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
 standardese::comment::config get_comment_config(const po::variables_map& variables)
 {
     standardese::comment::config::options options;
@@ -328,7 +395,11 @@ int main(int argc, char* argv[])
         ("verbose,v", po::value<bool>()->implicit_value(true)->default_value(false),
          "prints more information")
         ("jobs,j", po::value<unsigned>()->default_value(standardese_tool::default_no_threads()),
-         "sets the number of threads to use");
+         "sets the number of threads to use")
+        ("watch,w", po::value<bool>()->implicit_value(true)->default_value(false),
+         "keeps running and regenerates the documentation whenever an input file changes, implies output.write_if_changed")
+        ("profile", po::value<fs::path>(),
+         "writes the time spent on each file by each thread and the number of entities, comments, links and written bytes to the given file, in the trace event format of chrome://tracing");
 
     configuration.add_options()
         ("input.source_ext",
@@ -362,6 +433,8 @@ int main(int argc, char* argv[])
         ("input.extract_private",
          po::value<bool>()->implicit_value(true)->default_value(false),
          "whether or not to document private entities")
+        ("input.cache_dir", po::value<std::string>(),
+         "a directory where the hashes of the inputs are stored, if neither the input files, the files they include nor the options changed since the previous run, nothing is parsed; implies output.write_if_changed")
 
         ("compilation.commands_dir", po::value<std::string>(),
          "the directory where a compile_commands.json is located, its options have lower priority than the other ones")
@@ -384,6 +457,9 @@ int main(int argc, char* argv[])
         ("compilation.ms_compatibility",
          po::value<bool>()->implicit_value(true)->default_value(default_msvc_comp()),
          "enable/disable MSVC compatibility (-fms-compatibility)")
+        ("compilation.fast_preprocessing",
+         po::value<bool>()->implicit_value(true)->default_value(false),
+         "only preprocess the input files themselves and not the headers they include, so shared headers aren't preprocessed again for every input; only correct if the inputs don't rely on macros of included headers")
 
         ("comment.command_character", po::value<char>()->default_value(standardese::comment::config::options().command_character),
          "character used to introduce special commands")
@@ -399,6 +475,8 @@ int main(int argc, char* argv[])
         ("output.prefix",
          po::value<std::string>()->default_value(""),
          "a prefix that will be added to all output files")
+        ("output.write_if_changed", po::value<bool>()->implicit_value(true)->default_value(false),
+         "only replace output files whose content changed and remove outputs of previous runs that aren't generated anymore, tracked in the file <output.prefix>standardese-manifest")
         ("output.format",
          po::value<std::vector<std::string>>()->default_value(std::vector<std::string>{"commonmark"}, "{commonmark}"),
          "the output format used (html, commonmark, commonmark_html, xml, text)")
@@ -432,10 +510,14 @@ int main(int argc, char* argv[])
         else
         {
             auto no_threads = get_option<unsigned>(options, "jobs").value();
+            auto watch      = get_option<bool>(options, "watch").value();
+            auto verbose    = get_option<bool>(options, "verbose").value();
+            auto profile    = get_option<fs::path>(options, "profile");
 
             auto compile_config = get_compile_config(options);
             auto database       = get_compilation_database(options);
-            auto input          = get_input(options);
+            auto fast_preprocessing
+                = get_option<bool>(options, "compilation.fast_preprocessing").value();
 
             auto comment_config    = get_comment_config(options);
             auto synopsis_config   = get_synopsis_config(options);
@@ -446,45 +528,157 @@ int main(int argc, char* argv[])
             auto formats = get_formats(options);
             auto prefix  = get_option<std::string>(options, "output.prefix").value();
 
-            standardese::linker linker;
-            register_external_documentations(linker, options);
+            // one pool for all stages, so each stage only waits for the jobs it depends on
+            standardese_tool::thread_pool pool(no_threads);
 
-            try
+            type_safe::optional<standardese_tool::input_cache> cache;
+            if (auto dir = get_option<std::string>(options, "input.cache_dir"))
             {
-                cppast::cpp_entity_index index;
-
-                std::clog << "parsing C++ files...\n";
-                auto parsed
-                    = standardese_tool::parse(compile_config, database, input, index, no_threads);
-                if (!parsed)
-                    return 1;
-
-                std::clog << "parsing documentation comments...\n";
-                auto comments
-                    = standardese_tool::parse_comments(comment_config, parsed.value(), no_threads);
-                auto files
-                    = standardese_tool::build_files(comments, index, std::move(parsed.value()),
-                                                    blacklist, generation_config.is_flag_set(standardese::generation_config::hide_uncommented), no_threads);
-
-                std::clog << "generating documentation...\n";
-                auto docs = standardese_tool::generate(generation_config, synopsis_config, comments,
-                                                       index, linker, files, no_threads);
-
-                for (auto& format : formats)
+                std::vector<fs::path> include_dirs;
+                if (auto includes
+                    = get_option<std::vector<std::string>>(options, "compilation.include_dir"))
+                    include_dirs.assign(includes.value().begin(), includes.value().end());
+                cache.emplace(dir.value(), get_cache_options(argc, argv, options),
+                              std::move(include_dirs));
+            }
+
+            std::vector<standardese_tool::output_format> outputs;
+            std::string                                  format_names;
+            for (auto& format : formats)
+            {
+                auto format_prefix
+                    = formats.size() > 1u ? std::string(format.second) + '/' + prefix : prefix;
+                if (!format_prefix.empty())
+                    fs::create_directories(fs::path(format_prefix).parent_path());
+                outputs.push_back({format.first, format.second, std::move(format_prefix)});
+
+                if (!format_names.empty())
+                    format_names += ", ";
+                format_names += "'" + std::string(format.second) + "'";
+            }
+
+            // in watch mode the manifest is kept for all runs,
+            // it is keyed by the prefix, so runs with other prefixes don't remove our outputs
+            type_safe::optional<standardese_tool::output_manifest> manifest;
+            if (watch || cache || get_option<bool>(options, "output.write_if_changed").value())
+            {
+                std::vector<std::string> output_prefixes;
+                for (auto& output : outputs)
+                    output_prefixes.push_back(fs::path(output.prefix).generic_string());
+                manifest.emplace(prefix + "standardese-manifest", std::move(output_prefixes));
+            }
+
+            auto run = [&](const std::vector<standardese_tool::input_file>& input) {
+                try
                 {
-                    std::clog << "writing files in format '" << format.second << "'...\n";
-
-                    auto format_prefix
-                        = formats.size() > 1u ? std::string(format.second) + '/' + prefix : prefix;
-                    if (!format_prefix.empty())
-                        fs::create_directories(fs::path(format_prefix).parent_path());
-                    standardese_tool::write_files(docs, format.first, std::move(format_prefix),
-                                                  format.second, no_threads);
+                    if (cache && cache.value().is_unchanged(input)
+                        && manifest.value().has_previous_outputs())
+                    {
+                        std::clog << "documentation is up to date\n";
+                        return true;
+                    }
+
+                    stage_timer timer(verbose);
+
+                    type_safe::optional<standardese_tool::profiler> profiler;
+                    if (profile)
+                        profiler.emplace();
+                    auto profiler_ref = type_safe::opt_ref(profiler ? &profiler.value() : nullptr);
+
+                    standardese::linker linker;
+                    register_external_documentations(linker, options);
+
+                    cppast::cpp_entity_index index;
+
+                    std::clog << "parsing C++ files and documentation comments...\n";
+                    standardese::file_comment_parser comment_parser(cppast::default_logger(),
+                                                                    comment_config,
+                                                                    type_safe::ref(blacklist));
+                    auto parsed = standardese_tool::parse(compile_config, database,
+                                                          fast_preprocessing, input, index,
+                                                          comment_parser, pool, profiler_ref);
+                    if (!parsed)
+                        return false;
+                    timer.finish_stage("parsing");
+
+                    if (cache)
+                        cache.value().record(parsed.value());
+
+                    auto comments = comment_parser.finish();
+                    auto files
+                        = standardese_tool::build_files(comments, index, std::move(parsed.value()),
+                                                        blacklist, generation_config.is_flag_set(standardese::generation_config::hide_uncommented), pool,
+                                                        profiler_ref);
+                    timer.finish_stage("building entities");
+
+                    std::clog << "generating documentation...\n";
+                    auto docs = standardese_tool::generate(generation_config, synopsis_config,
+                                                           comments, index, linker, files, pool,
+                                                           profiler_ref);
+                    timer.finish_stage("generating documentation");
+
+                    std::clog << "writing files in format " << format_names << "...\n";
+                    standardese_tool::write_files(docs, outputs, pool,
+                                                  type_safe::opt_ref(manifest ? &manifest.value()
+                                                                              : nullptr),
+                                                  profiler_ref);
+                    timer.finish_stage("writing files");
+
+                    if (profiler)
+                    {
+                        profiler.value().write(profile.value());
+                        std::clog << "wrote profile to '" << profile.value().generic_string()
+                                  << "'\n";
+                    }
+
+                    if (manifest)
+                    {
+                        auto removed = manifest.value().finish();
+                        if (removed > 0u)
+                            std::clog << "removed " << removed << " outdated output files\n";
+                    }
+
+                    if (cache)
+                        cache.value().save();
                 }
-            }
-            catch (std::exception& ex)
+                catch (std::exception& ex)
+                {
+                    std::cerr << "error: " << ex.what() << '\n';
+                }
+                return true;
+            };
+
+            if (!watch)
+                return run(get_input(options)) ? 0 : 1;
+
+            auto source_ext
+                = get_option<std::vector<std::string>>(options, "input.source_ext").value();
+            while (true)
             {
-                std::cerr << "error: " << ex.what() << '\n';
+                // watch before parsing, so changes made while generating aren't lost
+                auto                           input = get_input(options);
+                standardese_tool::file_watcher watcher(get_watched_directories(options, input));
+
+                run(input);
+
+                std::clog << "watching for changes...\n";
+                for (auto changed = false; !changed;)
+                {
+                    auto paths = watcher.wait(std::chrono::milliseconds(100));
+                    if (paths.empty())
+                    {
+                        std::clog << "too many changes to tell which files changed\n";
+                        changed = true;
+                    }
+
+                    for (auto& path : paths)
+                        // ignore changes to the output and temporary files of editors
+                        if (standardese_tool::detail::is_source_file(path, source_ext))
+                        {
+                            std::clog << "'" << path.generic_string() << "' changed\n";
+                            changed = true;
+                        }
+                }
             }
         }
     }
@@ -0,0 +1,121 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "profiler.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+
+using namespace standardese_tool;
+
+namespace
+{
+// small consecutive ids are easier to read in the trace viewer than std::thread::id
+unsigned get_thread_id()
+{
+    static std::atomic<unsigned> next_id(0u);
+    thread_local auto            id = next_id++;
+    return id;
+}
+
+void write_json_string(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (auto c : str)
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buffer[7];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", unsigned(c));
+            out << buffer;
+        }
+        else
+            out << c;
+    out << '"';
+}
+} // namespace
+
+std::uint64_t profiler::now() const
+{
+    return std::uint64_t(
+        std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start_).count());
+}
+
+void profiler::add_span(std::string name, std::string detail, std::uint64_t begin)
+{
+    auto end    = now();
+    auto thread = get_thread_id();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back({std::move(name), std::move(detail), begin, end - begin, thread, 'X'});
+}
+
+void profiler::count(const char* name, std::uint64_t value)
+{
+    auto time = now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& counter = counters_[name];
+    counter += value;
+    // record the new total, so the trace shows how the counter grows
+    events_.push_back({name, "", time, counter, 0u, 'C'});
+}
+
+std::uint64_t profiler::counter(const char* name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        iter = counters_.find(name);
+    return iter == counters_.end() ? 0u : iter->second;
+}
+
+void profiler::write(const fs::path& path) const
+{
+    std::ofstream out(path.string());
+    out << "{\"traceEvents\":[\n";
+
+    auto first = true;
+    for (auto& e : events_)
+    {
+        if (first)
+            first = false;
+        else
+            out << ",\n";
+
+        out << "{\"name\":";
+        write_json_string(out, e.name);
+        out << ",\"ph\":\"" << e.phase << "\",\"ts\":" << e.begin << ",\"pid\":1";
+        if (e.phase == 'X')
+        {
+            out << ",\"tid\":" << e.thread << ",\"dur\":" << e.value;
+            if (!e.detail.empty())
+            {
+                out << ",\"args\":{\"file\":";
+                write_json_string(out, e.detail);
+                out << '}';
+            }
+        }
+        else
+            out << ",\"args\":{\"value\":" << e.value << '}';
+        out << '}';
+    }
+
+    out << "\n]}\n";
+}
+
+profile_span::~profile_span() noexcept
+{
+    if (profiler_)
+    {
+        try
+        {
+            profiler_.value().add_span(name_, std::move(detail_), begin_);
+        }
+        catch (...)
+        {
+            // losing a span is better than terminating
+        }
+    }
+}
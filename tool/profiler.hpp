@@ -0,0 +1,93 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_PROFILER_HPP_INCLUDED
+#define STANDARDESE_TOOL_PROFILER_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <type_safe/optional_ref.hpp>
+
+#include "filesystem.hpp"
+
+namespace standardese_tool
+{
+/// Records how long the stages of the tool take on each thread,
+/// and counts what they produce.
+///
+/// The result is written in the trace event format of Chrome,
+/// it can be viewed in `chrome://tracing` or Perfetto.
+class profiler
+{
+public:
+    profiler() : start_(clock::now()) {}
+
+    /// \effects Adds `value` to the counter of the given name.
+    /// \notes This function is thread safe.
+    void count(const char* name, std::uint64_t value);
+
+    /// \returns The current value of the counter of the given name.
+    std::uint64_t counter(const char* name) const;
+
+    /// \effects Writes the trace to the given file.
+    void write(const fs::path& path) const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct event
+    {
+        std::string   name, detail;
+        std::uint64_t begin; // in microseconds
+        std::uint64_t value; // duration of a span in microseconds, total of a counter
+        unsigned      thread;
+        char          phase; // 'X' for a span, 'C' for a counter
+    };
+
+    std::uint64_t now() const;
+
+    void add_span(std::string name, std::string detail, std::uint64_t begin);
+
+    clock::time_point                    start_;
+    mutable std::mutex                   mutex_;
+    std::vector<event>                   events_;
+    std::map<std::string, std::uint64_t> counters_;
+
+    friend class profile_span;
+};
+
+/// A span of time in the trace of a [standardese_tool::profiler]().
+///
+/// It lasts from its construction until its destruction.
+/// If there is no profiler, it does nothing.
+class profile_span
+{
+public:
+    /// \effects Begins the span with the given name,
+    /// `detail` is shown as argument, e.g. the name of the file that is processed.
+    explicit profile_span(type_safe::optional_ref<profiler> p, const char* name,
+                          std::string detail = "")
+    : profiler_(p), name_(name), detail_(std::move(detail)), begin_(p ? p.value().now() : 0u)
+    {}
+
+    profile_span(const profile_span&) = delete;
+    profile_span& operator=(const profile_span&) = delete;
+
+    /// \effects Ends the span.
+    ~profile_span() noexcept;
+
+private:
+    type_safe::optional_ref<profiler> profiler_;
+    const char*                       name_;
+    std::string                       detail_;
+    std::uint64_t                     begin_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_PROFILER_HPP_INCLUDED
@@ -26,6 +26,17 @@ auto add_job(thread_pool& p, Fnc f, Args&&... args)
 {
     return p.enqueue(f, std::forward<Args>(args)...);
 }
+
+/// Waits until all jobs have finished.
+/// If one of them has thrown an exception, it is rethrown.
+inline void wait_for(std::vector<std::future<void>>& jobs)
+{
+    for (auto& job : jobs)
+        job.wait();
+    for (auto& job : jobs)
+        job.get();
+    jobs.clear();
+}
 } // namespace standardese_tool
 
 #endif // STANDARDESE_THREAD_POOL_HPP_INCLUDED
@@ -0,0 +1,157 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "watcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace standardese_tool;
+
+namespace
+{
+void sort_unique(std::vector<fs::path>& paths)
+{
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+}
+} // namespace
+
+#ifdef __linux__
+file_watcher::file_watcher(const std::vector<fs::path>& directories)
+: fd_(inotify_init1(IN_CLOEXEC))
+{
+    if (fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "unable to initialize inotify");
+
+    for (auto& dir : directories)
+    {
+        auto wd = inotify_add_watch(fd_, dir.c_str(),
+                                    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                        | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            auto error = errno;
+            close(fd_);
+            throw std::system_error(error, std::generic_category(),
+                                    "unable to watch '" + dir.generic_string() + "'");
+        }
+        watches_.emplace(wd, dir);
+    }
+}
+
+file_watcher::~file_watcher() noexcept
+{
+    close(fd_);
+}
+
+bool file_watcher::read_events(std::vector<fs::path>& changed, bool& overflow, int timeout_ms)
+{
+    pollfd fd{fd_, POLLIN, 0};
+    auto   result = poll(&fd, 1, timeout_ms);
+    // a signal must not end the waiting early
+    while (result < 0 && errno == EINTR)
+        result = poll(&fd, 1, timeout_ms);
+    if (result < 0)
+        throw std::system_error(errno, std::generic_category(), "unable to wait for changes");
+    else if (result == 0)
+        return false;
+
+    alignas(inotify_event) char buffer[4096];
+    auto                        size = read(fd_, buffer, sizeof(buffer));
+    while (size < 0 && errno == EINTR)
+        size = read(fd_, buffer, sizeof(buffer));
+    if (size < 0)
+        throw std::system_error(errno, std::generic_category(), "unable to read changes");
+
+    for (auto ptr = buffer; ptr < buffer + size;)
+    {
+        auto event = reinterpret_cast<const inotify_event*>(ptr);
+        if (event->mask & IN_Q_OVERFLOW)
+            // the queue was full, e.g. after a checkout, so any file might have changed
+            overflow = true;
+        else
+        {
+            auto iter = watches_.find(event->wd);
+            if (iter != watches_.end() && event->len > 0u)
+                changed.push_back(iter->second / event->name);
+        }
+        ptr += sizeof(inotify_event) + event->len;
+    }
+    return true;
+}
+
+std::vector<fs::path> file_watcher::wait(std::chrono::milliseconds delay)
+{
+    std::vector<fs::path> changed;
+    auto                  overflow = false;
+    while (changed.empty() && !overflow)
+        read_events(changed, overflow, -1);
+    while (read_events(changed, overflow, int(delay.count())))
+        ;
+
+    if (overflow)
+        return {};
+
+    sort_unique(changed);
+    return changed;
+}
+#else
+file_watcher::file_watcher(const std::vector<fs::path>& directories)
+: directories_(directories), snapshot_(take_snapshot())
+{}
+
+file_watcher::~file_watcher() noexcept = default;
+
+file_watcher::snapshot file_watcher::take_snapshot() const
+{
+    snapshot result;
+    for (auto& dir : directories_)
+    {
+        boost::system::error_code ec;
+        for (fs::directory_iterator iter(dir, ec), end; !ec && iter != end; iter.increment(ec))
+            if (fs::is_regular_file(iter->path()))
+                result.emplace(iter->path(), fs::last_write_time(iter->path(), ec));
+    }
+    return result;
+}
+
+std::vector<fs::path> file_watcher::wait(std::chrono::milliseconds delay)
+{
+    constexpr auto interval = std::chrono::milliseconds(500);
+
+    std::vector<fs::path> changed;
+    auto                  add_changes = [&](const snapshot& cur) {
+        auto old_size = changed.size();
+        for (auto& file : cur)
+        {
+            auto iter = snapshot_.find(file.first);
+            if (iter == snapshot_.end() || iter->second != file.second)
+                changed.push_back(file.first);
+        }
+        for (auto& file : snapshot_)
+            if (cur.count(file.first) == 0u)
+                changed.push_back(file.first);
+        snapshot_ = cur;
+        return changed.size() != old_size;
+    };
+
+    while (!add_changes(take_snapshot()))
+        std::this_thread::sleep_for(interval);
+    do
+        std::this_thread::sleep_for(delay);
+    while (add_changes(take_snapshot()));
+
+    sort_unique(changed);
+    return changed;
+}
+#endif
@@ -0,0 +1,60 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_WATCHER_HPP_INCLUDED
+#define STANDARDESE_TOOL_WATCHER_HPP_INCLUDED
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "filesystem.hpp"
+
+namespace standardese_tool
+{
+/// Watches directories for changes of the files in them.
+///
+/// It uses inotify on Linux and polls the modification times everywhere else.
+class file_watcher
+{
+public:
+    /// \effects Starts watching the given directories, but not their subdirectories.
+    explicit file_watcher(const std::vector<fs::path>& directories);
+
+    file_watcher(const file_watcher&) = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+
+    ~file_watcher() noexcept;
+
+    /// \effects Blocks until a file in one of the directories has been created, written,
+    /// removed or renamed.
+    /// Changes following each other within `delay` are reported together,
+    /// so saving multiple files only triggers one regeneration.
+    /// \returns The paths of the changed files,
+    /// or an empty vector if it isn't known which files changed,
+    /// e.g. because there were too many changes at once.
+    std::vector<fs::path> wait(std::chrono::milliseconds delay);
+
+private:
+#ifdef __linux__
+    // appends the files of all pending events, returns false if there weren't any,
+    // sets `overflow` if events were lost
+    bool read_events(std::vector<fs::path>& changed, bool& overflow, int timeout_ms);
+
+    int                               fd_;
+    std::unordered_map<int, fs::path> watches_;
+#else
+    using snapshot = std::map<fs::path, std::time_t>;
+
+    snapshot take_snapshot() const;
+
+    std::vector<fs::path> directories_;
+    snapshot              snapshot_;
+#endif
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_WATCHER_HPP_INCLUDED